@@ -0,0 +1,58 @@
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include "allocationCount.h"
+
+static std::atomic<std::uint64_t> allocations {0};
+
+std::uint64_t AllocationCount::total()
+{
+    return allocations.load(std::memory_order_relaxed);
+}
+
+#ifdef COUNT_ALLOCATIONS
+
+static void* countedAllocate(std::size_t size, std::size_t alignment = 0)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+
+    size = (size == 0) ? 1 : size;
+    void* memory {(alignment == 0) ? std::malloc(size) : std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)};
+    if (!memory)
+    {
+        throw std::bad_alloc {};
+    }
+    return memory;
+}
+
+void* operator new(std::size_t size) { return countedAllocate(size); }
+void* operator new[](std::size_t size) { return countedAllocate(size); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return countedAllocate(size, static_cast<std::size_t>(alignment)); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return countedAllocate(size, static_cast<std::size_t>(alignment)); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    try
+    {
+        return countedAllocate(size);
+    }
+    catch (const std::bad_alloc&)
+    {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept { return operator new(size, tag); }
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete(void* memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept { std::free(memory); }
+
+#endif
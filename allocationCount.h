@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+
+// Building with -DCOUNT_ALLOCATIONS replaces the global operator new with one that counts every call, so the
+// benchmark and the interactive mode can report heap allocations per trial. Otherwise the count stays at zero.
+namespace AllocationCount
+{
+#ifdef COUNT_ALLOCATIONS
+    constexpr bool enabled {true};
+#else
+    constexpr bool enabled {false};
+#endif
+
+    // Allocations made by all threads since the program started
+    std::uint64_t total();
+}
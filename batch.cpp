@@ -0,0 +1,380 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <future>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "deck.h"
+#include "range.h"
+#include "rng.h"
+#include "simulation.h"
+#include "threadPool.h"
+#include "preflopTable.h"
+#include "decision.h"
+#include "batch.h"
+
+static constexpr std::int64_t defaultTrials {10000};
+
+static bool parseCount(std::string_view text, std::int64_t& count)
+{
+    std::string digits {text};
+    char* end {};
+    count = std::strtoll(digits.c_str(), &end, 10);
+    return !digits.empty() && *end == '\0' && count > 0;
+}
+
+std::string parseScenario(std::string_view line, BatchRequest& request)
+{
+    struct Hand
+    {
+        std::optional<CardSet> cards {};
+        std::optional<Range> range {};
+    };
+
+    std::optional<Hand> hero {};
+    std::vector<Hand> villains {};
+    CardSet board {};
+    std::int64_t players {0};
+    std::int64_t trials {defaultTrials};
+    double precision {0};
+    PotOdds odds {};
+    Sampling::Method sampler {Sampling::plain};
+    bool control {false};
+    double deadline {0};
+
+    while (!line.empty())
+    {
+        auto start {line.find_first_not_of(" \t\r")};
+        if (start == std::string_view::npos)
+        {
+            break;
+        }
+        line.remove_prefix(start);
+        auto field {line.substr(0, line.find_first_of(" \t\r"))};
+        line.remove_prefix(field.size());
+
+        auto equals {field.find('=')};
+        if (equals == std::string_view::npos)
+        {
+            return "expected key=value";
+        }
+        auto key {field.substr(0, equals)};
+        auto value {field.substr(equals + 1)};
+
+        if (key == "hero" || key == "villain")
+        {
+            Hand hand {};
+            auto cards {CardSet::fromString(value)};
+            if (cards && cards->size() == 2)
+            {
+                hand.cards = cards;
+            }
+            else if (auto range {Range::parse(value)}; range && !range->empty())
+            {
+                hand.range = std::move(*range);
+            }
+            else
+            {
+                return "bad hand or range";
+            }
+
+            if (key == "hero")
+            {
+                hero = std::move(hand);
+            }
+            else
+            {
+                villains.push_back(std::move(hand));
+            }
+        }
+        else if (key == "board")
+        {
+            auto cards {CardSet::fromString(value)};
+            if (!cards || cards->size() == 1 || cards->size() == 2 || cards->size() > 5)
+            {
+                return "bad board";
+            }
+            board = *cards;
+        }
+        else if (key == "players")
+        {
+            if (!parseCount(value, players))
+            {
+                return "bad players";
+            }
+        }
+        else if (key == "pot" || key == "call")
+        {
+            std::string number {value};
+            char* end {};
+            double amount {std::strtod(number.c_str(), &end)};
+            if (number.empty() || *end != '\0' || !(amount >= 0))
+            {
+                return "bad " + std::string {key};
+            }
+            (key == "pot" ? odds.pot : odds.toCall) = amount;
+        }
+        else if (key == "trials")
+        {
+            if (!parseCount(value, trials))
+            {
+                return "bad trials";
+            }
+        }
+        else if (key == "precision")
+        {
+            std::string number {value};
+            char* end {};
+            precision = std::strtod(number.c_str(), &end);
+            if (number.empty() || *end != '\0' || !(precision > 0))
+            {
+                return "bad precision";
+            }
+        }
+        else if (key == "sampler")
+        {
+            auto method {Sampling::parse(value)};
+            if (!method)
+            {
+                return "bad sampler";
+            }
+            sampler = *method;
+        }
+        else if (key == "control")
+        {
+            if (value != "0" && value != "1")
+            {
+                return "bad control";
+            }
+            control = value == "1";
+        }
+        else if (key == "deadline")
+        {
+            std::string number {value};
+            char* end {};
+            deadline = std::strtod(number.c_str(), &end);
+            if (number.empty() || *end != '\0' || !(deadline > 0))
+            {
+                return "bad deadline";
+            }
+        }
+        else
+        {
+            return "unknown key";
+        }
+    }
+
+    std::int64_t handsGiven {static_cast<std::int64_t>(villains.size()) + (hero ? 1 : 0)};
+    if (players == 0)
+    {
+        players = std::max<std::int64_t>(handsGiven, 2);
+    }
+    if (players < 2 || players < handsGiven || 2 * players + 5 > 52)
+    {
+        return "bad players";
+    }
+
+    // Seat order is fixed hands, then ranges, then random hands, with the hero in seat 0
+    std::vector<Hand> seats {};
+    if (hero)
+    {
+        seats.push_back(std::move(*hero));
+    }
+    for (auto& villain : villains)
+    {
+        if (villain.cards)
+        {
+            seats.push_back(std::move(villain));
+        }
+    }
+    for (auto& villain : villains)
+    {
+        if (villain.range)
+        {
+            seats.push_back(std::move(villain));
+        }
+    }
+
+    request = BatchRequest {};
+    request.trials = trials;
+    request.precision = precision;
+    request.odds = odds;
+    request.sampler = sampler;
+    request.control = control;
+    request.deadline = deadline;
+
+    Scenario& scenario {request.scenario};
+    scenario.numPlayers = static_cast<int>(players);
+    scenario.players.resize(static_cast<std::size_t>(players));
+    scenario.numCommunal = board.size();
+    scenario.communalCards = board;
+
+    CardSet usedCards {board};
+    for (std::size_t seat {0}; seat < seats.size(); ++seat)
+    {
+        if (seats[seat].cards)
+        {
+            if (scenario.numHands != static_cast<int>(seat))
+            {
+                return "hero must be a fixed hand when a villain is";
+            }
+            if (seats[seat].cards->intersects(usedCards))
+            {
+                return "card used twice";
+            }
+            usedCards |= *seats[seat].cards;
+            scenario.players[seat].hand = *seats[seat].cards;
+            ++scenario.numHands;
+        }
+        else
+        {
+            scenario.ranges.push_back(std::move(*seats[seat].range));
+        }
+    }
+
+    if (!hero && !seats.empty())
+    {
+        return "hero must be given when a villain is";
+    }
+
+    return {};
+}
+
+EquityResult computeRequest(const BatchRequest& request, Xoshiro256& rng, const PreflopTable* preflop)
+{
+    Sampling sampling {request.sampler, request.control ? preflop : nullptr};
+    RunControl control {};
+    if (request.deadline > 0)
+    {
+        control = RunControl::within(std::chrono::duration_cast<RunControl::Clock::duration>(
+            std::chrono::duration<double, std::milli> {request.deadline}));
+    }
+
+    return request.precision > 0 ?
+        calculateToPrecision(request.scenario, request.precision, request.trials, 1, rng, preflop, 1.96, sampling,
+            control) :
+        calculate(request.scenario, request.trials, 1, rng, preflop, sampling, control);
+}
+
+EquityResult runRequest(const BatchRequest& request, Xoshiro256& rng, const PreflopTable* preflop, EquityCache* cache)
+{
+    std::string key {};
+    if (cache)
+    {
+        key = EquityCache::key(request.scenario);
+        if (auto cached {cache->find(key, request.trials, request.precision)})
+        {
+            return *cached;
+        }
+    }
+
+    auto result {computeRequest(request, rng, preflop)};
+
+    // A result cut short by its deadline holds fewer trials than were asked for, so it is not kept
+    if (cache && !result.stopped)
+    {
+        cache->insert(key, result);
+    }
+    return result;
+}
+
+std::string formatResult(std::size_t lineNumber, const EquityResult& result, PotOdds odds)
+{
+    char buffer[160] {};
+    if (result.trials == 0)
+    {
+        std::snprintf(buffer, sizeof(buffer), "line=%zu error=no runouts possible\n", lineNumber);
+        return buffer;
+    }
+
+    auto trials {static_cast<double>(result.trials)};
+    std::snprintf(buffer, sizeof(buffer),
+        "line=%zu equity=%.6f margin=%.6f win=%.6f draw=%.6f loss=%.6f trials=%lld mode=%s", lineNumber,
+        result.equity(), result.margin(), static_cast<double>(result.wins) / trials, static_cast<double>(result.draws) / trials,
+        static_cast<double>(result.losses()) / trials, static_cast<long long>(result.trials),
+        result.methodName());
+
+    std::string line {buffer};
+    if (result.stopped)
+    {
+        line += " stopped=1";
+    }
+    for (int seat {0}; seat < static_cast<int>(result.seatShares.size()); ++seat)
+    {
+        std::snprintf(buffer, sizeof(buffer), "%s%.6f", (seat == 0) ? " seats=" : ",", result.seatEquity(seat));
+        line += buffer;
+    }
+
+    if (odds.toCall > 0)
+    {
+        auto decision {decide(result, odds)};
+        std::snprintf(buffer, sizeof(buffer), " breakeven=%.6f call_ev=%.6f decision=%s", decision.breakEven,
+            decision.callEv, decision.call ? "call" : "fold");
+        line += buffer;
+    }
+    return line + "\n";
+}
+
+void runBatch(std::istream& in, std::ostream& out, unsigned threads, std::uint64_t seed, const PreflopTable* preflop,
+    EquityCache* cache)
+{
+    ThreadPool pool {threads};
+
+    // Results are written in input order, keeping a bounded window of scenarios in flight
+    std::size_t window {static_cast<std::size_t>(pool.size()) * 64};
+    std::deque<std::future<std::string>> pending {};
+    std::string buffer {};
+
+    auto writeOldest = [&]()
+    {
+        buffer += pending.front().get();
+        pending.pop_front();
+        if (buffer.size() >= (1 << 16))
+        {
+            out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            buffer.clear();
+        }
+    };
+
+    std::string line {};
+    std::size_t lineNumber {0};
+    while (std::getline(in, line))
+    {
+        ++lineNumber;
+        auto first {line.find_first_not_of(" \t\r")};
+        if (first == std::string::npos || line[first] == '#')
+        {
+            continue;
+        }
+
+        // Each line has its own stream, so its result does not depend on which worker runs it or when
+        auto rng {Xoshiro256::stream(seed, lineNumber)};
+        pending.push_back(pool.submit([line, lineNumber, preflop, cache, rng]() mutable
+        {
+            BatchRequest request {};
+            auto error {parseScenario(line, request)};
+            if (!error.empty())
+            {
+                return "line=" + std::to_string(lineNumber) + " error=" + error + "\n";
+            }
+            return formatResult(lineNumber, runRequest(request, rng, preflop, cache), request.odds);
+        }));
+
+        if (pending.size() >= window)
+        {
+            writeOldest();
+        }
+    }
+
+    while (!pending.empty())
+    {
+        writeOldest();
+    }
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    out.flush();
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include "simulation.h"
+#include "preflopTable.h"
+#include "equityCache.h"
+#include "decision.h"
+
+// Batch scenarios are one per line, as whitespace separated key=value fields:
+//     hero=AsKs villain=QdQc villain=TT+,AKs board=2c7c9d players=4 trials=20000
+// hero and each villain take an exact hand or a range, board takes 0, 3, 4 or 5 cards, players defaults to the
+// number of hands given (at least two) and trials to 10000. precision=0.001 samples until the 95% confidence
+// interval is that narrow, with trials as the limit. pot=150 call=50 (chips, the pot including the bet faced) adds
+// the call decision. sampler=stratified, antithetic or quasi picks a variance-reduced sampler (see Sampling in
+// simulation.h) and control=1 adds the preflop table as a control variate when one is loaded. deadline=50 stops
+// sampling 50 milliseconds after the line starts running and answers with the trials done by then (see RunControl in
+// simulation.h). Seats are filled with fixed hands first, then ranges, then
+// random hands, so the hero must be fixed whenever any villain is. Blank lines and lines starting with # are skipped.
+struct BatchRequest
+{
+    Scenario scenario {};
+    std::int64_t trials {};
+    double precision {0};
+    PotOdds odds {};
+    Sampling::Method sampler {Sampling::plain};
+    bool control {false};
+
+    // Milliseconds, or 0 for none
+    double deadline {0};
+};
+
+// Fills request from one line, returning an error message or an empty string
+std::string parseScenario(std::string_view line, BatchRequest& request);
+
+// Computes one parsed request, without a cache
+EquityResult computeRequest(const BatchRequest& request, Xoshiro256& rng, const PreflopTable* preflop);
+
+// Runs one parsed request, answering it from cache when that holds a good enough result for an equivalent scenario
+EquityResult runRequest(const BatchRequest& request, Xoshiro256& rng, const PreflopTable* preflop,
+    EquityCache* cache = nullptr);
+
+// The output line runBatch writes for result, numbered lineNumber, ending in a newline
+std::string formatResult(std::size_t lineNumber, const EquityResult& result, PotOdds odds);
+
+// Writes one line per scenario to out, in input order:
+//     line=3 equity=0.657300 margin=0.006575 win=0.652300 draw=0.010000 loss=0.337700 trials=20000 mode=sampled
+// or line=3 error=<message> when the line could not be read. margin is the half-width of the 95% interval.
+// stopped=1 follows the mode when a deadline cut the sampling short.
+// Computed results then give seats=0.657300,0.342700, every seat's equity in seat order, and requests with a call
+// amount end with breakeven=0.250000 call_ev=81.460000 decision=call. Line n samples from stream(seed, n), so
+// without a cache or deadlines the output depends only on the input and seed, not on threads.
+void runBatch(std::istream& in, std::ostream& out, unsigned threads, std::uint64_t seed,
+    const PreflopTable* preflop = nullptr, EquityCache* cache = nullptr);
@@ -0,0 +1,736 @@
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "allocationCount.h"
+#include "deck.h"
+#include "equityCalc.h"
+#include "handStrength.h"
+#include "pokerGame.h"
+#include "rng.h"
+#include "simulation.h"
+#include "decision.h"
+#include "equityCache.h"
+#include "strengthDistribution.h"
+#include "preflopTable.h"
+#include "server.h"
+#include "profile.h"
+
+// Fixed-seed workloads for tracking performance between versions. Prints one JSON object to stdout:
+//     {"seed": 1, "scale": 1, "benchmarks": [{"name": "...", "group": "...", "iterations": n, "seconds": s,
+//       "ns_per_op": x, "ops_per_second": y, "allocations_per_op": a, "trials_per_op": t, "p99_latency_us": l,
+//       "checksum": c, "profile": p}, ...]}
+// allocations_per_op is only counted in builds with -DCOUNT_ALLOCATIONS and is null otherwise. trials_per_op is
+// the mean number of trials a precision benchmark needed to reach its target margin, and null for the others.
+// The server benchmarks count requests as ops, with several clients pipelining at once, and also report
+// "p99_latency_us", the 99th percentile time from sending a request to reading its reply (null elsewhere).
+// Each benchmark also has "profile", the stage timings and evaluator counts of its timed run from a build with
+// -DPROFILE_STAGES and the hardware counters where perf_event allows them, in the form profile.h describes, or null
+// when there are neither.
+// The checksum folds every result together so the work cannot be optimised away, and should only change
+// between runs when the results themselves change.
+//
+// Usage: benchmark [--scale n] [--seed s] [--threads n] [--filter text] [--preflop file]
+// A preflop table adds precision benchmarks that use it as a control variate.
+
+namespace
+{
+    constexpr std::uint64_t defaultSeed {1};
+    constexpr std::size_t handPool {1 << 16};
+
+    struct Measurement
+    {
+        std::string name {};
+        std::string group {};
+        std::int64_t iterations {};
+        double seconds {};
+        std::uint64_t allocations {};
+        std::uint64_t checksum {};
+        double trials {};
+        double p99Latency {};
+        std::string profile {};
+    };
+
+    struct Options
+    {
+        std::int64_t scale {1};
+        std::uint64_t seed {defaultSeed};
+        unsigned threads {std::max(1u, std::thread::hardware_concurrency())};
+        std::string filter {};
+        std::string preflop {};
+    };
+
+    // Counts hardware events for the benchmarks, opened before any of their threads start
+    Profile::Hardware& hardware()
+    {
+        static Profile::Hardware counters {};
+        return counters;
+    }
+
+    // Runs func(i) for i in [0, iterations) once, after one untimed pass over a tenth of them to warm caches
+    template <typename Func>
+    Measurement measure(std::string_view group, std::string_view name, std::int64_t iterations, Func func)
+    {
+        std::uint64_t checksum {0};
+        for (std::int64_t i {0}; i < iterations / 10; ++i)
+        {
+            checksum += func(i);
+        }
+
+        checksum = 0;
+        Profile::reset();
+        hardware().start();
+        auto allocationsBefore {AllocationCount::total()};
+        auto start {std::chrono::steady_clock::now()};
+        for (std::int64_t i {0}; i < iterations; ++i)
+        {
+            checksum = checksum * 31 + func(i);
+        }
+        std::chrono::duration<double> elapsed {std::chrono::steady_clock::now() - start};
+        auto allocations {AllocationCount::total() - allocationsBefore};
+
+        Measurement result {std::string {name}, std::string {group}, iterations, elapsed.count(), allocations, checksum};
+        if (hardware().available())
+        {
+            auto reading {hardware().read()};
+            result.profile = Profile::json(Profile::totals(), &reading);
+        }
+        else if (Profile::enabled)
+        {
+            result.profile = Profile::json(Profile::totals());
+        }
+        return result;
+    }
+
+    // Random seven-card sets, as seen by each player at a river showdown
+    std::vector<CardSet> sevenCardHands(Xoshiro256& rng)
+    {
+        Deck deck {};
+        deck.removeDeadCards(CardSet {});
+
+        std::vector<CardSet> hands(handPool);
+        for (auto& hand : hands)
+        {
+            deck.startDeal();
+            for (int i {0}; i < 7; ++i)
+            {
+                hand.add(deck.dealCard(rng));
+            }
+        }
+        return hands;
+    }
+
+    struct Table
+    {
+        std::vector<Player> players {};
+        CardSet board {};
+    };
+
+    // Random complete deals for numPlayers players
+    std::vector<Table> tables(int numPlayers, std::size_t count, Xoshiro256& rng)
+    {
+        Deck deck {};
+        deck.removeDeadCards(CardSet {});
+
+        std::vector<Table> result(count);
+        for (auto& table : result)
+        {
+            deck.startDeal();
+            for (int i {0}; i < numPlayers; ++i)
+            {
+                Player player {deck.dealCard(rng), deck.dealCard(rng)};
+                player.isPlayer = i == 0;
+                table.players.push_back(player);
+            }
+            for (int i {0}; i < 5; ++i)
+            {
+                table.board.add(deck.dealCard(rng));
+            }
+        }
+        return result;
+    }
+
+    std::uint64_t cardsChecksum(const BestHand& cards)
+    {
+        std::uint64_t sum {cards.size()};
+        for (auto card : cards)
+        {
+            sum = sum * 53 + card.code();
+        }
+        return sum;
+    }
+
+    Scenario makeScenario(int numPlayers, std::string_view hero, std::string_view board)
+    {
+        Scenario scenario {};
+        scenario.numPlayers = numPlayers;
+        scenario.players.resize(static_cast<std::size_t>(numPlayers));
+        scenario.players[0].isPlayer = true;
+        if (!hero.empty())
+        {
+            scenario.players[0].hand = CardSet {*Card::fromString(hero.substr(0, 2)), *Card::fromString(hero.substr(2, 2))};
+            scenario.numHands = 1;
+        }
+        for (std::size_t i {0}; i + 2 <= board.size(); i += 2)
+        {
+            scenario.communalCards.add(*Card::fromString(board.substr(i, 2)));
+            ++scenario.numCommunal;
+        }
+        return scenario;
+    }
+
+    std::uint64_t resultChecksum(const EquityResult& result)
+    {
+        return static_cast<std::uint64_t>(result.wins) * 1000003 + static_cast<std::uint64_t>(result.draws);
+    }
+
+    std::string cardsText(CardSet cards)
+    {
+        std::ostringstream out {};
+        cards.forEach([&](Card card) { out << card; });
+        return out.str();
+    }
+
+    // Random spots as server request lines: a hero hand, numVillains known villain hands and a board of boardCards
+    std::vector<std::string> spots(std::size_t count, int numVillains, int boardCards, std::string_view extra,
+        Xoshiro256& rng)
+    {
+        Deck deck {};
+        deck.removeDeadCards(CardSet {});
+
+        std::vector<std::string> lines(count);
+        for (auto& line : lines)
+        {
+            deck.startDeal();
+            auto hand = [&]() { return CardSet {deck.dealCard(rng), deck.dealCard(rng)}; };
+            line = "hero=" + cardsText(hand());
+            for (int i {0}; i < numVillains; ++i)
+            {
+                line += " villain=" + cardsText(hand());
+            }
+
+            CardSet board {};
+            for (int i {0}; i < boardCards; ++i)
+            {
+                board.add(deck.dealCard(rng));
+            }
+            line += (boardCards > 0 ? " board=" + cardsText(board) : "") + " " + std::string {extra} + "\n";
+        }
+        return lines;
+    }
+
+    // Sends lines in order over one connection to the Unix socket at path, with at most window requests awaiting
+    // replies, and adds each reply's latency in seconds to latencies. Returns the number of replies without an error.
+    std::uint64_t runClient(const std::string& path, const std::vector<std::string>& lines, std::size_t window,
+        std::vector<double>& latencies)
+    {
+        int fd {socket(AF_UNIX, SOCK_STREAM, 0)};
+        sockaddr_un address {};
+        address.sun_family = AF_UNIX;
+        std::copy(path.begin(), path.end(), address.sun_path);
+        if (fd < 0 || connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+        {
+            close(fd);
+            return 0;
+        }
+
+        using Clock = std::chrono::steady_clock;
+        std::deque<Clock::time_point> sentAt {};
+        std::size_t sent {0};
+        std::size_t received {0};
+        std::uint64_t answered {0};
+        std::string input {};
+        char buffer[1 << 16];
+
+        while (received < lines.size())
+        {
+            std::string batch {};
+            for (; sent < lines.size() && sent - received < window; ++sent)
+            {
+                batch += lines[sent];
+                sentAt.push_back(Clock::now());
+            }
+            if (!batch.empty() && send(fd, batch.data(), batch.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(batch.size()))
+            {
+                break;
+            }
+
+            auto got {recv(fd, buffer, sizeof(buffer), 0)};
+            if (got <= 0)
+            {
+                break;
+            }
+            input.append(buffer, static_cast<std::size_t>(got));
+
+            std::size_t start {0};
+            for (auto end {input.find('\n')}; end != std::string::npos; end = input.find('\n', start))
+            {
+                std::chrono::duration<double> latency {Clock::now() - sentAt.front()};
+                latencies.push_back(latency.count());
+                sentAt.pop_front();
+                answered += std::string_view {input}.substr(start, end - start).find("error=") == std::string_view::npos;
+                ++received;
+                start = end + 1;
+            }
+            input.erase(0, start);
+        }
+
+        close(fd);
+        return answered;
+    }
+
+    void printJson(const Options& options, const std::vector<Measurement>& measurements)
+    {
+        std::printf("{\n  \"seed\": %llu,\n  \"scale\": %lld,\n  \"threads\": %u,\n  \"benchmarks\": [",
+            static_cast<unsigned long long>(options.seed), static_cast<long long>(options.scale), options.threads);
+
+        for (std::size_t i {0}; i < measurements.size(); ++i)
+        {
+            const auto& m {measurements[i]};
+            double perOp {m.seconds / static_cast<double>(m.iterations)};
+
+            char allocations[32] {"null"};
+            if (AllocationCount::enabled)
+            {
+                std::snprintf(allocations, sizeof(allocations), "%.4f",
+                    static_cast<double>(m.allocations) / static_cast<double>(m.iterations));
+            }
+
+            char trials[32] {"null"};
+            if (m.trials > 0)
+            {
+                std::snprintf(trials, sizeof(trials), "%.1f", m.trials);
+            }
+
+            char latency[32] {"null"};
+            if (m.p99Latency > 0)
+            {
+                std::snprintf(latency, sizeof(latency), "%.1f", m.p99Latency * 1e6);
+            }
+
+            std::printf("%s\n    {\"name\": \"%s\", \"group\": \"%s\", \"iterations\": %lld, \"seconds\": %.6f, "
+                "\"ns_per_op\": %.3f, \"ops_per_second\": %.1f, \"allocations_per_op\": %s, \"trials_per_op\": %s, "
+                "\"p99_latency_us\": %s, \"checksum\": %llu, \"profile\": %s}",
+                i == 0 ? "" : ",", m.name.c_str(), m.group.c_str(), static_cast<long long>(m.iterations), m.seconds,
+                perOp * 1e9, perOp > 0 ? 1.0 / perOp : 0.0, allocations, trials, latency,
+                static_cast<unsigned long long>(m.checksum), m.profile.empty() ? "null" : m.profile.c_str());
+        }
+        std::printf("\n  ]\n}\n");
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<std::string_view> args(argv + 1, argv + argc);
+
+    Options options {};
+    for (std::size_t i {0}; i < args.size(); ++i)
+    {
+        if (args[i] == "--scale" && i + 1 < args.size())
+        {
+            options.scale = std::max(1LL, std::stoll(std::string {args[++i]}));
+        }
+        else if (args[i] == "--seed" && i + 1 < args.size())
+        {
+            options.seed = std::stoull(std::string {args[++i]});
+        }
+        else if (args[i] == "--threads" && i + 1 < args.size())
+        {
+            options.threads = static_cast<unsigned>(std::max(1, std::stoi(std::string {args[++i]})));
+        }
+        else if (args[i] == "--filter" && i + 1 < args.size())
+        {
+            options.filter = args[++i];
+        }
+        else if (args[i] == "--preflop" && i + 1 < args.size())
+        {
+            options.preflop = args[++i];
+        }
+        else
+        {
+            std::cerr << "Unknown argument: " << args[i] << '\n';
+            return 1;
+        }
+    }
+
+    PreflopTable preflop {};
+    if (!options.preflop.empty() && !preflop.open(options.preflop))
+    {
+        std::cerr << "Could not load the preflop table " << options.preflop << '\n';
+        return 1;
+    }
+
+    Xoshiro256 rng {options.seed};
+
+    std::vector<Measurement> measurements {};
+    auto run = [&](std::string_view group, std::string_view name, std::int64_t iterations, auto func)
+    {
+        std::string fullName {std::string {group} + "/" + std::string {name}};
+        if (!options.filter.empty() && fullName.find(options.filter) == std::string::npos)
+        {
+            return false;
+        }
+        std::cerr << fullName << '\n';
+        measurements.push_back(measure(group, name, iterations * options.scale, func));
+        return true;
+    };
+
+    // Seven card indices per op, as dealing a showdown needs, from the old global generator's method and ours
+    {
+        std::mt19937 mt {static_cast<std::mt19937::result_type>(options.seed)};
+        run("rng", "mt19937_uniform_int_7", 2000000, [&](std::int64_t)
+        {
+            std::uint64_t sum {0};
+            for (int i {0}; i < 7; ++i)
+            {
+                sum = sum * 53 + static_cast<std::uint64_t>(std::uniform_int_distribution {0, 51 - i}(mt));
+            }
+            return sum;
+        });
+
+        Xoshiro256 generator {options.seed};
+        run("rng", "xoshiro_below_7", 2000000, [&](std::int64_t)
+        {
+            std::uint64_t sum {0};
+            for (int i {0}; i < 7; ++i)
+            {
+                sum = sum * 53 + generator.below(static_cast<std::uint32_t>(52 - i));
+            }
+            return sum;
+        });
+
+        run("rng", "split", 200000, [&](std::int64_t)
+        {
+            return generator.split()();
+        });
+    }
+
+    // Deck
+    {
+        Deck deck {};
+        Xoshiro256 generator {options.seed};
+        run("deck", "shuffle_deal_7", 200000, [&](std::int64_t)
+        {
+            deck.shuffle(generator);
+            std::uint64_t sum {0};
+            for (int i {0}; i < 7; ++i)
+            {
+                sum = sum * 53 + deck.dealCard().code();
+            }
+            return sum;
+        });
+
+        Deck liveDeck {};
+        liveDeck.removeDeadCards(CardSet {});
+        run("deck", "partial_deal_7", 2000000, [&](std::int64_t)
+        {
+            liveDeck.startDeal();
+            std::uint64_t sum {0};
+            for (int i {0}; i < 7; ++i)
+            {
+                sum = sum * 53 + liveDeck.dealCard(rng).code();
+            }
+            return sum;
+        });
+    }
+
+    // Evaluators on seven-card hands
+    {
+        auto hands {sevenCardHands(rng)};
+        auto hand = [&](std::int64_t i) { return hands[static_cast<std::size_t>(i) % hands.size()]; };
+
+        using Evaluator = BestHand (*)(CardSet);
+        const std::pair<std::string_view, Evaluator> evaluators[] {
+            {"straight_flush", straightFlush}, {"four_kind", fourOfKind}, {"full_house", fullHouse},
+            {"flush", flush}, {"straight", straight}, {"three_kind", threeOfKind}, {"two_pair", twoPair},
+            {"pair", pair}, {"high_card", highCard}};
+
+        for (const auto& [name, evaluator] : evaluators)
+        {
+            run("evaluator", name, 1000000, [&](std::int64_t i) { return cardsChecksum(evaluator(hand(i))); });
+        }
+
+        run("evaluator", "find_best_hand", 1000000, [&](std::int64_t i)
+        {
+            Player player {};
+            findBestHand(player, hand(i));
+            return static_cast<std::uint64_t>(player.handType) * 1000003 + cardsChecksum(player.bestHand);
+        });
+
+        run("evaluator", "hand_strength", 10000000, [&](std::int64_t i)
+        {
+            return static_cast<std::uint64_t>(HandStrength::evaluate(hand(i)));
+        });
+
+        // The same hands laid out card by card for the batch evaluator, once with each kernel the CPU supports
+        constexpr std::size_t block {1024};
+        std::array<std::vector<CardCode>, 7> columns {};
+        for (auto cards : hands)
+        {
+            std::size_t column {0};
+            for (std::uint64_t rest {cards.mask}; rest; rest &= rest - 1)
+            {
+                columns[column++].push_back(static_cast<CardCode>(std::countr_zero(rest)));
+            }
+        }
+
+        std::vector<HandStrength::Strength> strengths(block);
+        for (int k {0}; k < HandStrength::max_kernels; ++k)
+        {
+            auto kernel {static_cast<HandStrength::Kernel>(k)};
+            if (!HandStrength::supported(kernel))
+            {
+                continue;
+            }
+
+            run("batch_evaluator", HandStrength::kernelName(kernel), 10000000 / block, [&](std::int64_t i)
+            {
+                auto first {static_cast<std::size_t>(i) * block % hands.size()};
+                HandStrength::SevenCardColumns cards {};
+                for (std::size_t c {0}; c < cards.size(); ++c)
+                {
+                    cards[c] = columns[c].data() + first;
+                }
+
+                HandStrength::evaluate(cards, block, strengths.data(), kernel);
+                return std::accumulate(strengths.begin(), strengths.end(), std::uint64_t {0});
+            });
+        }
+
+        // Reported per hand, so ns_per_op compares directly with hand_strength
+        for (auto& m : measurements)
+        {
+            if (m.group == "batch_evaluator")
+            {
+                m.iterations *= block;
+            }
+        }
+    }
+
+    // Full showdowns
+    for (int numPlayers : {2, 6, 9})
+    {
+        auto deals {tables(numPlayers, handPool, rng)};
+        run("check_winner", std::to_string(numPlayers) + "_players", 1000000 / numPlayers, [&](std::int64_t i)
+        {
+            auto& table {deals[static_cast<std::size_t>(i) % deals.size()]};
+            return static_cast<std::uint64_t>(checkWinner(table.players, table.board));
+        });
+    }
+
+    // End-to-end equity, single-threaded then across all threads
+    {
+        constexpr std::int64_t tries {100000};
+
+        const std::pair<std::string_view, Scenario> scenarios[] {
+            {"heads_up_preflop", makeScenario(2, "AsKs", "")},
+            {"six_way_flop", makeScenario(6, "AsKs", "2c7c9d")},
+            {"nine_way_preflop", makeScenario(9, "QhQd", "")}};
+
+        for (const auto& [name, scenario] : scenarios)
+        {
+            run("equity_single", name, 1, [&](std::int64_t)
+            {
+                return resultChecksum(simulate(scenario, tries, rng));
+            });
+        }
+
+        for (const auto& [name, scenario] : scenarios)
+        {
+            run("equity_threaded", name, 1, [&](std::int64_t)
+            {
+                return resultChecksum(simulate(scenario, tries * 10, options.threads, rng));
+            });
+        }
+
+        // The trial counts are reported as iterations so ops_per_second reads as trials per second
+        for (auto& m : measurements)
+        {
+            if (m.group == "equity_single")
+            {
+                m.iterations *= tries;
+            }
+            else if (m.group == "equity_threaded")
+            {
+                m.iterations *= tries * 10;
+            }
+        }
+    }
+
+    // The fast decision tier, answered from a warm cache and from its own small sample
+    {
+        auto scenario {makeScenario(3, "AsKs", "2c7c9d")};
+        PotOdds odds {150, 50};
+
+        EquityCache cache {};
+        cache.insert(EquityCache::key(scenario), simulate(scenario, quickTrials, rng));
+
+        run("decision", "quick_cached", 100000, [&](std::int64_t)
+        {
+            return static_cast<std::uint64_t>(quickDecision(scenario, odds, rng, nullptr, &cache).callEv * 1000);
+        });
+        run("decision", "quick_sampled", 2000, [&](std::int64_t)
+        {
+            return static_cast<std::uint64_t>(quickDecision(scenario, odds, rng).call);
+        });
+    }
+
+    // Trials each sampler needs to bring the 95% margin under the target, against plain sampling
+    {
+        constexpr double target {0.005};
+        constexpr std::int64_t runs {10};
+
+        const std::pair<std::string_view, Scenario> scenarios[] {
+            {"heads_up_preflop", makeScenario(2, "JhTh", "")},
+            {"heads_up_flop", makeScenario(2, "AsKs", "2c7c9d")},
+            {"three_way_preflop", makeScenario(3, "QhQd", "")}};
+
+        for (const auto& [scenarioName, scenario] : scenarios)
+        {
+            for (int method {0}; method < Sampling::max_methods; ++method)
+            {
+                const PreflopTable* controls[] {nullptr, &preflop};
+                for (auto control : controls)
+                {
+                    if (control && !control->isOpen())
+                    {
+                        continue;
+                    }
+
+                    Sampling sampling {static_cast<Sampling::Method>(method), control};
+                    std::string name {std::string {scenarioName} + "/" + Sampling::name(sampling.method) +
+                        (control ? "+control" : "")};
+
+                    // The warm-up runs come first, so the last iterations entries are the timed ones
+                    std::vector<std::int64_t> trials {};
+                    bool ran {run("precision", name, runs, [&](std::int64_t)
+                    {
+                        auto result {calculateToPrecision(scenario, target, 10000000, rng, nullptr, 1.96, sampling)};
+                        trials.push_back(result.trials);
+                        return resultChecksum(result);
+                    })};
+
+                    if (ran)
+                    {
+                        auto& m {measurements.back()};
+                        auto timed {trials.end() - m.iterations};
+                        m.trials = static_cast<double>(std::accumulate(timed, trials.end(), std::int64_t {0})) /
+                            static_cast<double>(m.iterations);
+                    }
+                }
+            }
+        }
+    }
+
+    // Strength histograms for every hand on a flop, as computed when bucketing hands offline
+    {
+        auto board {*CardSet::fromString("2c7c9d")};
+        auto hands {allHands(board)};
+        run("strength_distribution", "flop_all_hands", 1, [&](std::int64_t)
+        {
+            std::uint64_t sum {0};
+            for (const auto& distribution : strengthDistributions(hands, board, nullptr, options.threads, rng))
+            {
+                sum = sum * 31 + static_cast<std::uint64_t>(distribution.ehsSquared * 1e6);
+            }
+            return sum;
+        });
+    }
+
+    // A server on a Unix socket under concurrent pipelined load: spots that are cached after their first request,
+    // distinct exact spots small enough to answer on the connection thread, and distinct spots sampled by the workers
+    {
+        constexpr int clients {4};
+        constexpr std::size_t window {16};
+
+        std::string path {"/tmp/equityCalc-benchmark-" + std::to_string(getpid()) + ".sock"};
+        EquityCache cache {};
+        EquityServer server {options.threads, options.seed, nullptr, cache};
+        if (auto error {server.listen(path)}; !error.empty())
+        {
+            std::cerr << error << '\n';
+            return 1;
+        }
+        std::thread serving {[&server] { server.run(); }};
+
+        auto cachedSpots {spots(64, 0, 3, "players=3 trials=20000", rng)};
+        std::vector<std::string> cached {};
+        for (std::size_t i {0}; i < 20000; ++i)
+        {
+            cached.push_back(cachedSpots[i % cachedSpots.size()]);
+        }
+
+        const std::pair<std::string_view, std::vector<std::string>> workloads[] {
+            {"cached_flop", cached},
+            {"exact_turn", spots(20000, 1, 4, "", rng)},
+            {"sampled_flop", spots(2000, 0, 3, "players=3 trials=5000", rng)}};
+
+        // Every cached spot is asked for once before the timed runs
+        std::vector<double> warmUp {};
+        runClient(path, cachedSpots, window, warmUp);
+
+        for (const auto& [name, workload] : workloads)
+        {
+            std::vector<std::vector<std::string>> clientLines(clients);
+            for (std::size_t i {0}; i < workload.size(); ++i)
+            {
+                clientLines[i % clients].push_back(workload[i]);
+            }
+
+            std::vector<std::vector<double>> latencies(clients);
+            bool ran {run("server", name, 1, [&](std::int64_t)
+            {
+                std::vector<std::uint64_t> answered(clients);
+                std::vector<std::thread> threads {};
+                for (std::size_t c {0}; c < clients; ++c)
+                {
+                    threads.emplace_back([&, c] { answered[c] = runClient(path, clientLines[c], window, latencies[c]); });
+                }
+                for (auto& thread : threads)
+                {
+                    thread.join();
+                }
+                return std::accumulate(answered.begin(), answered.end(), std::uint64_t {0});
+            })};
+
+            if (ran)
+            {
+                std::vector<double> all {};
+                for (const auto& clientLatencies : latencies)
+                {
+                    all.insert(all.end(), clientLatencies.begin(), clientLatencies.end());
+                }
+
+                auto& m {measurements.back()};
+                m.iterations = static_cast<std::int64_t>(all.size());
+                if (!all.empty())
+                {
+                    auto p99 {all.begin() + static_cast<std::ptrdiff_t>(all.size() * 99 / 100)};
+                    std::nth_element(all.begin(), p99, all.end());
+                    m.p99Latency = *p99;
+                }
+            }
+        }
+
+        server.stop();
+        serving.join();
+    }
+
+    printJson(options, measurements);
+
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include <cmath>
+#include <cstdint>
+#include <future>
+#include <string>
+#include "rng.h"
+#include "simulation.h"
+#include "preflopTable.h"
+#include "equityCache.h"
+#include "decision.h"
+
+double PotOdds::breakEven() const
+{
+    return (toCall > 0) ? toCall / (pot + toCall) : 0.0;
+}
+
+CallDecision decide(const EquityResult& result, PotOdds odds)
+{
+    CallDecision decision {};
+    decision.result = result;
+    decision.equity = result.equity();
+    decision.margin = result.margin();
+    decision.breakEven = odds.breakEven();
+    decision.callEv = decision.equity * (odds.pot + odds.toCall) - odds.toCall;
+    decision.call = decision.callEv > 0;
+    decision.clear = std::abs(decision.equity - decision.breakEven) > decision.margin;
+    return decision;
+}
+
+CallDecision quickDecision(const Scenario& scenario, PotOdds odds, Xoshiro256& rng, const PreflopTable* preflop,
+    EquityCache* cache)
+{
+    if (preflop)
+    {
+        if (auto result {preflop->lookup(scenario)})
+        {
+            return decide(*result, odds);
+        }
+    }
+
+    if (cache)
+    {
+        // Any stored result beats a few hundred fresh trials
+        if (auto cached {cache->find(EquityCache::key(scenario), quickTrials)})
+        {
+            return decide(*cached, odds);
+        }
+    }
+
+    auto decision {decide(simulate(scenario, quickTrials, rng), odds)};
+    decision.approximate = true;
+    return decision;
+}
+
+std::future<CallDecision> accurateDecision(const Scenario& scenario, PotOdds odds, double precision,
+    std::int64_t maxTries, unsigned threads, Xoshiro256 rng, const PreflopTable* preflop, EquityCache* cache,
+    const Sampling& sampling, const RunControl& control)
+{
+    return std::async(std::launch::async, [scenario, odds, precision, maxTries, threads, rng, preflop, cache, sampling,
+        control]() mutable
+    {
+        std::string key {cache ? EquityCache::key(scenario) : std::string {}};
+        if (cache)
+        {
+            if (auto cached {cache->find(key, maxTries, precision)})
+            {
+                return decide(*cached, odds);
+            }
+        }
+
+        auto result {(precision > 0) ?
+            calculateToPrecision(scenario, precision, maxTries, threads, rng, preflop, 1.96, sampling, control) :
+            calculate(scenario, maxTries, threads, rng, preflop, sampling, control)};
+        if (cache && !result.stopped)
+        {
+            cache->insert(key, result);
+        }
+        return decide(result, odds);
+    });
+}
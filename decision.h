@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <future>
+#include "rng.h"
+#include "simulation.h"
+#include "preflopTable.h"
+#include "equityCache.h"
+
+// The pot before calling, including the bet faced, and the amount needed to call, both in chips
+struct PotOdds
+{
+    double pot {0};
+    double toCall {0};
+
+    // The equity at which calling and folding are worth the same: toCall / (pot + toCall)
+    double breakEven() const;
+};
+
+struct CallDecision
+{
+    EquityResult result {};
+    double equity {};
+    double margin {};
+    double breakEven {};
+
+    // Chips won on average by calling rather than folding: equity * (pot + toCall) - toCall
+    double callEv {};
+
+    bool call {false};
+
+    // True when the whole 95% interval around equity lies on one side of breakEven
+    bool clear {false};
+
+    // True when the answer came from the fast tier's small sample rather than a table, cache or full run
+    bool approximate {false};
+};
+
+CallDecision decide(const EquityResult& result, PotOdds odds);
+
+// The fast tier, for real-time use: answers from the preflop table or the cache when they can, and otherwise from
+// quickTrials sampled trials on the calling thread, marking the decision approximate. Never writes to the cache.
+constexpr std::int64_t quickTrials {400};
+CallDecision quickDecision(const Scenario& scenario, PotOdds odds, Xoshiro256& rng,
+    const PreflopTable* preflop = nullptr, EquityCache* cache = nullptr);
+
+// The accurate tier: samples on threads workers in the background until the 95% margin is within precision (or
+// maxTries is reached; exactly maxTries trials when precision is not positive), stores the result in cache unless
+// control stopped it, and delivers the decision through the future. The background task owns rng, which callers
+// usually split off their own generator, and calls control.onProgress on its own thread.
+std::future<CallDecision> accurateDecision(const Scenario& scenario, PotOdds odds, double precision,
+    std::int64_t maxTries, unsigned threads, Xoshiro256 rng, const PreflopTable* preflop = nullptr,
+    EquityCache* cache = nullptr, const Sampling& sampling = {}, const RunControl& control = {});
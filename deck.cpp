@@ -1,40 +1,82 @@
 #include <iostream>
 #include <cassert>
+#include <cctype>
+#include <cstdint>
 #include <string>
 #include <algorithm>
 #include <vector>
-#include "Random.h"
 #include "deck.h"
 
 
-bool Card::operator==(Card otherCard)
+bool Card::operator==(Card otherCard) const
 {
     return ((rank == otherCard.rank) && (suit == otherCard.suit));
 }
 
 bool Card::operator<(const Card& otherCard) const
 {
+    return rankOrder() < otherCard.rankOrder();
+}
 
-    auto cardVal {(rank == rank_ace) ? max_ranks : rank};
-    auto otherCardVal {(otherCard.rank == rank_ace) ? max_ranks : otherCard.rank};
+int Card::valueFromChar(char r)
+{
+    auto upper {static_cast<char>(std::toupper(static_cast<unsigned char>(r)))};
+    auto pos {std::find(ranks.begin(), ranks.end(), upper)};
+    if (pos == ranks.end())
+    {
+        return -1;
+    }
 
-    if (groupBySuitSort)
+    return Card {static_cast<Ranks>(std::distance(ranks.begin(), pos)), suit_clubs}.value();
+}
+
+int Card::suitFromChar(char s)
+{
+    auto upper {static_cast<char>(std::toupper(static_cast<unsigned char>(s)))};
+    auto pos {std::find(suits.begin(), suits.end(), upper)};
+    if (pos == suits.end())
     {
-        if (suit != otherCard.suit)
-        {
-            return suit < otherCard.suit;
-        }
+        return -1;
+    }
 
-        return cardVal < otherCardVal;
+    return static_cast<int>(std::distance(suits.begin(), pos));
+}
+
+std::optional<Card> Card::fromString(std::string_view text)
+{
+    if (text.size() != 2)
+    {
+        return std::nullopt;
     }
-    
-    if (cardVal != otherCardVal)
+
+    int value {valueFromChar(text[0])};
+    int suit {suitFromChar(text[1])};
+    if (value < 0 || suit < 0)
     {
-        return cardVal < otherCardVal;
+        return std::nullopt;
     }
 
-    return suit < otherCard.suit;
+    return fromCode(static_cast<CardCode>(suit * max_ranks + value));
+}
 
+std::optional<CardSet> CardSet::fromString(std::string_view text)
+{
+    if (text.size() % 2 != 0)
+    {
+        return std::nullopt;
+    }
+
+    CardSet cards {};
+    for (std::size_t i {0}; i < text.size(); i += 2)
+    {
+        auto card {Card::fromString(text.substr(i, 2))};
+        if (!card || cards.contains(*card))
+        {
+            return std::nullopt;
+        }
+        cards.add(*card);
+    }
+    return cards;
 }
 
 Deck::Deck()
@@ -44,45 +86,103 @@ Deck::Deck()
     {
         for (auto r : Card::allRanks)
         {
-            m_deck[counter] = Card {r, s};
+            m_deck[counter] = Card {r, s}.code();
             ++counter;
         }
     }
 }
 
-void Deck::shuffle()
+void Deck::shuffle(Xoshiro256& rng)
 {
-    m_cardsChosen.clear();
-    std::shuffle(m_deck.begin(), m_deck.end(), Random::mt);
-    m_nextCardIndex = 0;
+    shuffle(CardSet {}, rng);
 }
 
-void Deck::shuffle(const std::vector<Card>& cardsChosen)
+void Deck::shuffle(CardSet cardsChosen, Xoshiro256& rng)
 {
     m_cardsChosen = cardsChosen;
-    std::shuffle(m_deck.begin(), m_deck.end(), Random::mt);
+    std::shuffle(m_deck.begin(), m_deck.end(), rng);
     m_nextCardIndex = 0;
 }
 
 Card Deck::dealCard()
 {
     assert(m_nextCardIndex != 52 && "Deck::dealCard ran out of cards");
-    while (in(m_deck[m_nextCardIndex],m_cardsChosen))
+    while (m_cardsChosen.mask & CardSet::bit(m_deck[m_nextCardIndex]))
     {
         ++m_nextCardIndex;
     }
-    return m_deck[m_nextCardIndex++];
+    return Card::fromCode(m_deck[m_nextCardIndex++]);
+}
+
+bool Deck::in(Card card, CardSet set)
+{
+    return set.contains(card);
+}
+void Deck::removeDeadCards(CardSet deadCards)
+{
+    m_liveSize = 0;
+    for (CardCode code {0}; code < m_decksize; ++code)
+    {
+        if (!(deadCards.mask & CardSet::bit(code)))
+        {
+            m_live[m_liveSize++] = code;
+        }
+    }
+    m_nextCardIndex = 0;
 }
 
-bool Deck::in(Card card, const std::vector<Card>& set)
+static void enumerateRunouts(const std::vector<CardCode>& live, std::size_t start, int cardsLeft, CardSet board,
+    std::vector<CardSet>& runouts)
 {
-    for (auto i : set)
+    if (cardsLeft == 0)
+    {
+        runouts.push_back(board);
+        return;
+    }
+
+    for (std::size_t i {start}; i + static_cast<std::size_t>(cardsLeft) <= live.size(); ++i)
     {
-        if (card == i)
+        enumerateRunouts(live, i + 1, cardsLeft - 1, CardSet {board.mask | CardSet::bit(live[i])}, runouts);
+    }
+}
+
+std::vector<CardSet> boardRunouts(CardSet board, std::int64_t maxRunouts, Xoshiro256& rng, bool& exact)
+{
+    int missing {5 - board.size()};
+    std::vector<CardCode> live {};
+    for (CardCode code {0}; code < 52; ++code)
+    {
+        if (!(board.mask & CardSet::bit(code)))
         {
-            return true;
+            live.push_back(code);
         }
     }
 
-    return false;
-}
\ No newline at end of file
+    double count {1};
+    for (int i {0}; i < missing; ++i)
+    {
+        count = count * static_cast<double>(live.size() - static_cast<std::size_t>(i)) / (i + 1);
+    }
+
+    std::vector<CardSet> boards {};
+    exact = count <= static_cast<double>(maxRunouts);
+    if (exact)
+    {
+        boards.reserve(static_cast<std::size_t>(count));
+        enumerateRunouts(live, 0, missing, board, boards);
+        return boards;
+    }
+
+    Deck deck {};
+    deck.removeDeadCards(board);
+    boards.resize(static_cast<std::size_t>(maxRunouts), board);
+    for (auto& runout : boards)
+    {
+        deck.startDeal();
+        for (int i {0}; i < missing; ++i)
+        {
+            runout.add(deck.dealCard(rng));
+        }
+    }
+    return boards;
+}
@@ -1,8 +1,21 @@
 #pragma once
 
 #include <iostream>
+#include <array>
+#include <cassert>
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <initializer_list>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <utility>
 #include <vector>
-#include "Random.h"
+#include "rng.h"
+
+// Compact one-byte card encoding: suit * 13 + value, where value orders the ranks 2..A as 0..12
+using CardCode = std::uint8_t;
 
 struct Card
 {
@@ -42,18 +55,47 @@ struct Card
     Ranks rank {};
     Suits suit {};
 
+    // Rank strength with the ace high: 2 is 0, ace is 12
+    constexpr int value() const
+    {
+        return (rank == rank_ace) ? max_ranks - 1 : rank - 1;
+    }
+
+    constexpr CardCode code() const
+    {
+        return static_cast<CardCode>(static_cast<int>(suit) * max_ranks + value());
+    }
+
+    static constexpr Card fromCode(CardCode code)
+    {
+        int value {code % max_ranks};
+        return Card {static_cast<Ranks>((value + 1) % max_ranks), static_cast<Suits>(code / max_ranks)};
+    }
+
     friend std::ostream& operator<<(std::ostream& out, const Card& card)
     {
         out << ranks[card.rank] << suits[card.suit];
         return out;
     }
 
-    bool operator==(Card otherCard);
+    bool operator==(Card otherCard) const;
 
-    inline static bool groupBySuitSort {true};
+    // Precomputed ordering key: sorts by value then suit
+    constexpr int rankOrder() const
+    {
+        return value() * max_suits + suit;
+    }
 
+    // Same order as rankOrder()
     bool operator<(const Card& otherCard) const;
 
+    // Value for a rank character such as 'T' or suit for a suit character such as 'h' (either case), or -1
+    static int valueFromChar(char r);
+    static int suitFromChar(char s);
+
+    // Reads a two character card such as "Ah" or "TS"
+    static std::optional<Card> fromString(std::string_view text);
+
     friend std::istream& operator>>(std::istream& in, Card& card)
     {
         char r {};
@@ -93,18 +135,116 @@ struct Card
         static constexpr std::array suits { 'C', 'D', 'H', 'S' };
 };
 
+// A set of cards stored as a 52-bit mask, one bit per CardCode.
+// Each suit occupies 13 consecutive bits ordered by value, so suitMask() gives the ranks held in that suit
+// with the ace as the highest bit.
+struct CardSet
+{
+    static constexpr std::uint16_t suitBits {0x1FFF};
+
+    std::uint64_t mask {0};
+
+    constexpr CardSet() = default;
+
+    constexpr explicit CardSet(std::uint64_t cardMask)
+    : mask {cardMask} {}
+
+    constexpr CardSet(std::initializer_list<Card> cards)
+    {
+        for (auto card : cards)
+        {
+            add(card);
+        }
+    }
+
+    static constexpr std::uint64_t bit(CardCode code)
+    {
+        return std::uint64_t {1} << code;
+    }
+
+    // Reads a run of two character cards such as "2c7c9d", failing on a repeated card
+    static std::optional<CardSet> fromString(std::string_view text);
+
+    constexpr void add(Card card) { mask |= bit(card.code()); }
+    constexpr void remove(Card card) { mask &= ~bit(card.code()); }
+    constexpr bool contains(Card card) const { return mask & bit(card.code()); }
+    constexpr bool intersects(CardSet other) const { return mask & other.mask; }
+    constexpr bool empty() const { return mask == 0; }
+    constexpr int size() const { return std::popcount(mask); }
+
+    constexpr std::uint16_t suitMask(int suit) const
+    {
+        return static_cast<std::uint16_t>((mask >> (suit * Card::max_ranks)) & suitBits);
+    }
+
+    // The values present in any suit
+    constexpr std::uint16_t rankMask() const
+    {
+        return static_cast<std::uint16_t>(suitMask(Card::suit_clubs) | suitMask(Card::suit_diamonds) |
+            suitMask(Card::suit_hearts) | suitMask(Card::suit_spades));
+    }
+
+    // Calls func(card) for every card in the set, lowest code first
+    template <typename Func>
+    constexpr void forEach(Func func) const
+    {
+        for (std::uint64_t rest {mask}; rest; rest &= rest - 1)
+        {
+            func(Card::fromCode(static_cast<CardCode>(std::countr_zero(rest))));
+        }
+    }
+
+    constexpr CardSet operator|(CardSet other) const { return CardSet {mask | other.mask}; }
+    constexpr CardSet operator&(CardSet other) const { return CardSet {mask & other.mask}; }
+    constexpr CardSet& operator|=(CardSet other) { mask |= other.mask; return *this; }
+    constexpr bool operator==(const CardSet& other) const = default;
+};
+
 class Deck
 {
     private:
         static constexpr size_t m_decksize {52};
-        std::array<Card, m_decksize> m_deck {};
+        std::array<CardCode, m_decksize> m_deck {};
         std::size_t m_nextCardIndex {0};
-        std::vector <Card> m_cardsChosen {};
+        CardSet m_cardsChosen {};
+        std::array<CardCode, m_decksize> m_live {};
+        std::size_t m_liveSize {0};
 
     public:
         Deck();
-        void shuffle();
-        void shuffle(const std::vector<Card>& cardsChosen);
+        void shuffle(Xoshiro256& rng);
+        void shuffle(CardSet cardsChosen, Xoshiro256& rng);
         Card dealCard();
-        bool in(Card card, const std::vector<Card>& set);
-};
\ No newline at end of file
+        bool in(Card card, CardSet set);
+
+        // Partial dealing. removeDeadCards() builds the live deck once per scenario; each trial then calls
+        // startDeal() and deals with dealCard(rng), which swaps a random live card into place (one step of a
+        // Fisher-Yates shuffle), so a trial only shuffles the cards it uses and dead cards are never scanned.
+        void removeDeadCards(CardSet deadCards);
+
+        void startDeal()
+        {
+            m_nextCardIndex = 0;
+        }
+
+        // Cards in skip (dead for this trial only, such as range hands) are passed over
+        Card dealCard(Xoshiro256& rng, CardSet skip = {})
+        {
+            while (true)
+            {
+                assert(m_nextCardIndex < m_liveSize && "Deck::dealCard ran out of cards");
+                auto remaining {static_cast<std::uint32_t>(m_liveSize - m_nextCardIndex)};
+                std::swap(m_live[m_nextCardIndex], m_live[m_nextCardIndex + rng.below(remaining)]);
+
+                auto code {m_live[m_nextCardIndex++]};
+                if (!(skip.mask & CardSet::bit(code)))
+                {
+                    return Card::fromCode(code);
+                }
+            }
+        }
+};
+
+// Every completion of board to five cards when there are at most maxRunouts of them, setting exact, and otherwise
+// maxRunouts random ones drawn from rng
+std::vector<CardSet> boardRunouts(CardSet board, std::int64_t maxRunouts, Xoshiro256& rng, bool& exact);
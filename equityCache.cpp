@@ -0,0 +1,361 @@
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <optional>
+#include <string>
+#include <vector>
+#include "deck.h"
+#include "pokerGame.h"
+#include "simulation.h"
+#include "equityCache.h"
+
+using SuitPermutation = std::array<int, Card::max_suits>;
+
+static constexpr char cacheMagic[8] {'E', 'Q', 'C', 'A', 'C', 'H', 'E', '2'};
+
+// The fields of an EquityResult as stored on disk
+struct StoredResult
+{
+    std::int64_t wins {};
+    std::int64_t draws {};
+    std::int64_t trials {};
+    double equityTotal {};
+    double equitySquares {};
+    std::int32_t method {};
+};
+
+// The longest key() can give: the three counts, the board, and a hand or a full range of every combo for each seat
+static constexpr std::size_t maxRangeSize {sizeof(std::uint32_t) +
+    52 * 51 / 2 * (sizeof(std::uint64_t) + sizeof(double))};
+static constexpr std::size_t maxKeySize {3 + sizeof(std::uint64_t) +
+    Settings::maxPlayers * std::max(sizeof(std::uint64_t), maxRangeSize)};
+
+static CardSet permute(CardSet cards, const SuitPermutation& to)
+{
+    CardSet result {};
+    for (int suit {0}; suit < Card::max_suits; ++suit)
+    {
+        result.mask |= static_cast<std::uint64_t>(cards.suitMask(suit)) << (to[static_cast<std::size_t>(suit)] * Card::max_ranks);
+    }
+    return result;
+}
+
+template <typename T>
+static void append(std::string& key, T value)
+{
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    key.append(bytes, sizeof(T));
+}
+
+static std::string encodeRange(const Range& range, const SuitPermutation& to)
+{
+    std::vector<Combo> combos {range.combos()};
+    for (auto& combo : combos)
+    {
+        combo.cards = permute(combo.cards, to);
+    }
+    std::sort(combos.begin(), combos.end(), [](const Combo& a, const Combo& b) { return a.cards.mask < b.cards.mask; });
+
+    std::string encoded {};
+    append(encoded, static_cast<std::uint32_t>(combos.size()));
+    for (const auto& combo : combos)
+    {
+        append(encoded, combo.cards.mask);
+        append(encoded, combo.weight);
+    }
+    return encoded;
+}
+
+// The board, the hero's hand and the sorted villain hands under one suit permutation. Seat 0 is the hero and keeps
+// its place; the villains are interchangeable.
+struct Cards
+{
+    std::array<std::uint64_t, Settings::maxPlayers + 1> masks {};
+    std::size_t size {};
+
+    bool operator<(const Cards& other) const
+    {
+        return std::lexicographical_compare(masks.begin(), masks.begin() + static_cast<std::ptrdiff_t>(size),
+            other.masks.begin(), other.masks.begin() + static_cast<std::ptrdiff_t>(other.size));
+    }
+
+    bool operator==(const Cards& other) const
+    {
+        return size == other.size && std::equal(masks.begin(), masks.begin() + static_cast<std::ptrdiff_t>(size),
+            other.masks.begin());
+    }
+};
+
+static Cards permuteCards(const Scenario& scenario, const SuitPermutation& to)
+{
+    Cards cards {};
+    cards.masks[cards.size++] = permute(scenario.communalCards, to).mask;
+    for (int seat {0}; seat < scenario.numHands; ++seat)
+    {
+        cards.masks[cards.size++] = permute(scenario.players[static_cast<std::size_t>(seat)].hand, to).mask;
+    }
+    if (cards.size > 2)
+    {
+        std::sort(cards.masks.begin() + 2, cards.masks.begin() + static_cast<std::ptrdiff_t>(cards.size));
+    }
+    return cards;
+}
+
+// The ranges under one permutation, the hero's first when seat 0 has no fixed hand, then the villains' sorted
+static std::string encodeRanges(const Scenario& scenario, const SuitPermutation& to)
+{
+    std::string key {};
+    std::vector<std::string> villainRanges {};
+    for (std::size_t i {0}; i < scenario.ranges.size(); ++i)
+    {
+        auto range {encodeRange(scenario.ranges[i], to)};
+        if (i == 0 && scenario.numHands == 0)
+        {
+            key += range;
+        }
+        else
+        {
+            villainRanges.push_back(std::move(range));
+        }
+    }
+    std::sort(villainRanges.begin(), villainRanges.end());
+    for (const auto& range : villainRanges)
+    {
+        key += range;
+    }
+
+    return key;
+}
+
+static bool better(const EquityResult& candidate, const EquityResult& current)
+{
+    if ((candidate.method == EquityResult::sampled) != (current.method == EquityResult::sampled))
+    {
+        return candidate.method != EquityResult::sampled;
+    }
+    return candidate.trials > current.trials;
+}
+
+EquityCache::EquityCache(std::size_t capacity)
+: m_capacity {std::max<std::size_t>(capacity, 1)}
+{}
+
+std::string EquityCache::key(const Scenario& scenario)
+{
+    assert(scenario.numHands <= Settings::maxPlayers);
+
+    // The fixed cards decide between permutations on their own; the ranges, which are slow to encode, only break
+    // ties among the permutations that leave the fixed cards smallest
+    std::vector<SuitPermutation> tied {};
+    Cards best {};
+
+    // The smallest keys put the suits with the fewest board cards (then hero cards) in the highest lanes, so only
+    // permutations that order the suits that way need encoding
+    std::array<std::uint32_t, Card::max_suits> column {};
+    for (int suit {0}; suit < Card::max_suits; ++suit)
+    {
+        auto hero {(scenario.numHands > 0) ? scenario.players.front().hand.suitMask(suit) : 0};
+        column[static_cast<std::size_t>(suit)] = (std::uint32_t {scenario.communalCards.suitMask(suit)} << Card::max_ranks) | hero;
+    }
+
+    SuitPermutation to {};
+    std::iota(to.begin(), to.end(), 0);
+    do
+    {
+        SuitPermutation from {};
+        for (std::size_t suit {0}; suit < to.size(); ++suit)
+        {
+            from[static_cast<std::size_t>(to[suit])] = static_cast<int>(suit);
+        }
+
+        bool ordered {true};
+        for (std::size_t lane {1}; lane < from.size(); ++lane)
+        {
+            ordered = ordered && column[static_cast<std::size_t>(from[lane])] <= column[static_cast<std::size_t>(from[lane - 1])];
+        }
+        if (!ordered)
+        {
+            continue;
+        }
+
+        auto cards {permuteCards(scenario, to)};
+        if (tied.empty() || cards < best)
+        {
+            best = cards;
+            tied.assign(1, to);
+        }
+        else if (cards == best)
+        {
+            tied.push_back(to);
+        }
+    } while (std::next_permutation(to.begin(), to.end()));
+
+    std::string key {};
+    append(key, static_cast<std::uint8_t>(scenario.numPlayers));
+    append(key, static_cast<std::uint8_t>(scenario.numHands));
+    append(key, static_cast<std::uint8_t>(scenario.ranges.size()));
+    for (std::size_t i {0}; i < best.size; ++i)
+    {
+        append(key, best.masks[i]);
+    }
+
+    if (!scenario.ranges.empty())
+    {
+        std::string bestRanges {};
+        for (const auto& permutation : tied)
+        {
+            auto ranges {encodeRanges(scenario, permutation)};
+            if (bestRanges.empty() || ranges < bestRanges)
+            {
+                bestRanges = std::move(ranges);
+            }
+        }
+        key += bestRanges;
+    }
+
+    return key;
+}
+
+std::optional<EquityResult> EquityCache::find(const std::string& key, std::int64_t tries, double targetMargin)
+{
+    std::lock_guard lock {m_mutex};
+
+    auto found {m_index.find(key)};
+    if (found == m_index.end())
+    {
+        return std::nullopt;
+    }
+
+    const EquityResult& result {found->second->second};
+    bool enough {result.method != EquityResult::sampled ||
+        (targetMargin > 0 ? result.margin() <= targetMargin : result.trials >= tries)};
+    if (!enough)
+    {
+        return std::nullopt;
+    }
+
+    m_entries.splice(m_entries.begin(), m_entries, found->second);
+    return result;
+}
+
+void EquityCache::insert(const std::string& key, const EquityResult& result)
+{
+    // The key does not keep the villains' seat order, so per-seat equity cannot be reused. Only the counts and sums
+    // the file keeps are stored, so a control variate's correction is dropped and margins are taken over trials.
+    EquityResult stored {};
+    stored.wins = result.wins;
+    stored.draws = result.draws;
+    stored.trials = result.trials;
+    stored.equityTotal = result.equityTotal;
+    stored.equitySquares = result.equitySquares;
+    stored.method = result.method;
+
+    std::lock_guard lock {m_mutex};
+    insertLocked(key, stored);
+}
+
+void EquityCache::insertLocked(const std::string& key, const EquityResult& result)
+{
+    auto found {m_index.find(key)};
+    if (found != m_index.end())
+    {
+        if (better(result, found->second->second))
+        {
+            found->second->second = result;
+        }
+        m_entries.splice(m_entries.begin(), m_entries, found->second);
+        return;
+    }
+
+    m_entries.emplace_front(key, result);
+    m_index.emplace(key, m_entries.begin());
+
+    if (m_entries.size() > m_capacity)
+    {
+        m_index.erase(m_entries.back().first);
+        m_entries.pop_back();
+    }
+}
+
+std::size_t EquityCache::size() const
+{
+    std::lock_guard lock {m_mutex};
+    return m_entries.size();
+}
+
+bool EquityCache::load(const std::string& path)
+{
+    std::ifstream in {path, std::ios::binary};
+    char magic[sizeof(cacheMagic)] {};
+    std::uint64_t count {};
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, cacheMagic, sizeof(magic)) != 0 ||
+        !in.read(reinterpret_cast<char*>(&count), sizeof(count)))
+    {
+        return false;
+    }
+
+    std::vector<Entry> entries {};
+    for (std::uint64_t i {0}; i < count; ++i)
+    {
+        // A size no key can have means the file is corrupt, so it is not allocated
+        std::uint32_t keySize {};
+        if (!in.read(reinterpret_cast<char*>(&keySize), sizeof(keySize)) || keySize > maxKeySize)
+        {
+            return false;
+        }
+
+        std::string key(keySize, '\0');
+        StoredResult stored {};
+        if (!in.read(key.data(), keySize) || !in.read(reinterpret_cast<char*>(&stored), sizeof(stored)) ||
+            stored.method < 0 || stored.method >= EquityResult::max_methods)
+        {
+            return false;
+        }
+
+        EquityResult result {};
+        result.wins = stored.wins;
+        result.draws = stored.draws;
+        result.trials = stored.trials;
+        result.equityTotal = stored.equityTotal;
+        result.equitySquares = stored.equitySquares;
+        result.method = static_cast<EquityResult::Method>(stored.method);
+        entries.emplace_back(std::move(key), result);
+    }
+
+    std::lock_guard lock {m_mutex};
+    for (const auto& [key, result] : entries)
+    {
+        insertLocked(key, result);
+    }
+    return true;
+}
+
+bool EquityCache::save(const std::string& path) const
+{
+    std::lock_guard lock {m_mutex};
+
+    std::ofstream out {path, std::ios::binary};
+    std::uint64_t count {m_entries.size()};
+    out.write(cacheMagic, sizeof(cacheMagic));
+    out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+
+    for (auto entry {m_entries.rbegin()}; entry != m_entries.rend(); ++entry)
+    {
+        const auto& [key, result] {*entry};
+        auto keySize {static_cast<std::uint32_t>(key.size())};
+        StoredResult stored {result.wins, result.draws, result.trials, result.equityTotal, result.equitySquares,
+            static_cast<std::int32_t>(result.method)};
+
+        out.write(reinterpret_cast<const char*>(&keySize), sizeof(keySize));
+        out.write(key.data(), keySize);
+        out.write(reinterpret_cast<const char*>(&stored), sizeof(stored));
+    }
+
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include "simulation.h"
+
+// A bounded least-recently-used cache of equity results, keyed so that scenarios equal up to a renaming of the
+// suits (AhKh on 2c7c9d and AsKs on 2h7h9c) or a reordering of the villains share one entry.
+// All members lock, so batch workers can share one cache.
+class EquityCache
+{
+    public:
+        static constexpr std::size_t defaultCapacity {1 << 16};
+
+        explicit EquityCache(std::size_t capacity = defaultCapacity);
+
+        // The smallest encoding of scenario over all 24 suit permutations, with the villains' hands and ranges
+        // sorted. Equal keys mean equal equity for the hero. Without ranges this takes no allocation beyond the key.
+        static std::string key(const Scenario& scenario);
+
+        // A cached result that answers the request: an exact or table result, or a sampled one within
+        // targetMargin when that is positive and with at least tries trials otherwise
+        std::optional<EquityResult> find(const std::string& key, std::int64_t tries, double targetMargin = 0);
+
+        // Stores result, without its per-seat equity or variance reduction sums, unless the entry already holds a
+        // better one, evicting the least recently used entry when full
+        void insert(const std::string& key, const EquityResult& result);
+
+        std::size_t size() const;
+
+        // The file is a magic string and entry count followed by the entries, least recently used first, in native
+        // byte order. load() returns false if the file is missing or not a cache, leaving the cache unchanged.
+        bool load(const std::string& path);
+        bool save(const std::string& path) const;
+
+    private:
+        using Entry = std::pair<std::string, EquityResult>;
+
+        mutable std::mutex m_mutex {};
+        std::size_t m_capacity {};
+        std::list<Entry> m_entries {};
+        std::unordered_map<std::string, std::list<Entry>::iterator> m_index {};
+
+        void insertLocked(const std::string& key, const EquityResult& result);
+};
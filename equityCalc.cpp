@@ -1,12 +1,29 @@
 #include <iostream>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <csignal>
 #include <cassert>
 #include <vector>
 #include <ranges>
-#include <functional>
 #include <utility>
+#include <algorithm>
+#include <thread>
+#include <tuple>
+#include <limits>
+#include <optional>
+#include <string>
 #include "deck.h"
 #include "pokerGame.h"
 #include "equityCalc.h"
+#include "handStrength.h"
+#include "simulation.h"
+#include "range.h"
+#include "allocationCount.h"
+#include "outs.h"
+#include "decision.h"
+#include "rng.h"
+#include "profile.h"
 
 std::pair<int, std::vector<Player>> getHands(int numPlayers)
 {
@@ -40,14 +57,52 @@ std::pair<int, std::vector<Player>> getHands(int numPlayers)
     return {numHands, std::move(players)};
 }
 
-std::pair<int, std::vector<Card>> getCommunalCards()
+std::vector<Range> getRanges(int numPlayers, int numHands)
+{
+    std::cout << "Do you want to give players without a fixed hand a range? Type y or n: ";
+    char useRangesChar {};
+    std::cin >> useRangesChar;
+
+    std::vector<Range> ranges {};
+    if (useRangesChar != 'y')
+    {
+        return ranges;
+    }
+
+    std::cout << "How many ranges do you want to input? ";
+    int numRanges {};
+    std::cin >> numRanges;
+    assert(numHands + numRanges <= numPlayers);
+    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+
+    for (int i {0}; i<numRanges; ++i)
+    {
+        std::cout << "Input the range for player " << numHands+i+1 << " (e.g. TT+, AKs, KQo:0.5)\n";
+        while (true)
+        {
+            std::string line {};
+            std::getline(std::cin, line);
+            auto range {Range::parse(line)};
+            if (range && !range->empty())
+            {
+                ranges.push_back(std::move(*range));
+                break;
+            }
+            std::cout << "Invalid range. Try again: \n";
+        }
+    }
+
+    return ranges;
+}
+
+std::pair<int, CardSet> getCommunalCards()
 {
     std::cout << "Do you want to control the communal cards? Type y or n: ";
     char controlCommunalChar {};
     std::cin >> controlCommunalChar;
     bool controlCommunal {controlCommunalChar == 'y'};
 
-    std::vector<Card> communalCards(7);
+    CardSet communalCards {};
 
     int numCommunal {};
     if (controlCommunal)
@@ -59,17 +114,19 @@ std::pair<int, std::vector<Card>> getCommunalCards()
         for (int i {0}; i<numCommunal; ++i)
         {
             std::cout << "Input communal card " << i << '\n';
-            std::cin >> communalCards.data()[i];
+            Card card {};
+            std::cin >> card;
+            communalCards.add(card);
         }
     }
     
     return {numCommunal, std::move(communalCards)};
 }
 
-Settings::GameStates checkWinner(std::vector<Player>& players, std::vector<Card>& communalCards)
+void findBestHand(Player& player, CardSet communalCards)
 {
-    static const std::vector<HandFunction> handFunctions
-    {
+    static constexpr std::array<HandFunction, Settings::max_rankings> handFunctions
+    {{
     {&straightFlush, Settings::straight_flush},
     {&fourOfKind, Settings::four_kind},
     {&fullHouse, Settings::full_house},
@@ -79,127 +136,249 @@ Settings::GameStates checkWinner(std::vector<Player>& players, std::vector<Card>
     {&twoPair, Settings::two_pair},
     {&pair, Settings::pair},
     {&highCard, Settings::high_card}
-    };
+    }};
 
-    Settings::Rankings bestHandType {Settings::high_card};
-    std::vector<Player> winning {};
+    CardSet cards {communalCards | player.hand};
 
-    for (auto& player : players)
+    for (const auto& handFunc : handFunctions)
     {
-        communalCards.data()[5] = player.hand.data()[0];
-        communalCards.data()[6] = player.hand.data()[1];
-
-        for (const auto& handFunc : handFunctions)
+        auto bestHand = handFunc.function(cards);
+        if (!bestHand.empty())
         {
-            auto bestHand = handFunc.function(communalCards);
-            if (!bestHand.empty())
-            {
-            player.bestHand = std::move(bestHand);
+            player.bestHand = bestHand;
             player.handType = handFunc.ranking;
-
-            if (player.handType > bestHandType)
-            {
-                bestHandType = player.handType;
-                winning.clear();
-                winning.push_back(player);
-            }
-            else if (player.handType == bestHandType)
-            {
-                winning.push_back(player);
-            }
-            break;
-            }
+            return;
         }
     }
+}
 
-    std::sort(winning.begin(), winning.end());
+ShowdownResult showdown(std::vector<Player>& players, CardSet communalCards)
+{
+    HandStrength::Strength bestStrength {0};
+    HandStrength::Strength playerStrength {0};
+    int numBest {0};
 
-    for (int i {0}; i<std::ssize(winning); ++i)
+    HandStrength::Board board {communalCards};
+    for (auto& player : players)
     {
-        if (winning.data()[i].isPlayer && i==std::ssize(winning)-1)
+        auto strength {board.evaluate(player.hand)};
+        player.handType = HandStrength::category(strength);
+        Profile::countCategory(player.handType);
+
+        if (player.isPlayer)
         {
-            return Settings::win;
+            playerStrength = strength;
         }
-        if (winning.data()[i].isPlayer && winning.data()[i] == winning.back())
+
+        if (strength > bestStrength)
         {
-            return Settings::draw;
+            bestStrength = strength;
+            numBest = 1;
         }
-        if (winning.data()[i].isPlayer)
+        else if (strength == bestStrength)
         {
-            return Settings::loss;
+            ++numBest;
         }
     }
 
-    return Settings::loss;
+    if (playerStrength < bestStrength)
+    {
+        return {Settings::loss, numBest};
+    }
+
+    return {(numBest == 1) ? Settings::win : Settings::draw, numBest};
+}
 
+Settings::GameStates checkWinner(std::vector<Player>& players, CardSet communalCards)
+{
+    return showdown(players, communalCards).state;
 }
 
-void runTests(int tries)
+static Scenario askScenario()
 {
-    int wins {0};
-    int draws {0};
-    
-    Deck deck {};
+    Scenario scenario {};
 
     std::cout << "How many players do you want? ";
-    int numPlayers {};
-    std::cin >> numPlayers;
+    std::cin >> scenario.numPlayers;
 
-    auto [numHands, players] = getHands(numPlayers);
+    std::tie(scenario.numHands, scenario.players) = getHands(scenario.numPlayers);
+    scenario.ranges = getRanges(scenario.numPlayers, scenario.numHands);
 
-    auto [numCommunal, communalCards] = getCommunalCards();
+    std::tie(scenario.numCommunal, scenario.communalCards) = getCommunalCards();
+    return scenario;
+}
 
-    std::vector<Card> usedCards {};
-    usedCards.reserve(static_cast<std::size_t>(numHands*2+numCommunal));
-    for (std::size_t i {0}; i < static_cast<std::size_t>(numHands); ++i)
+static void printDecision(const CallDecision& decision)
+{
+    std::cout << "Break-even equity: " << 100 * decision.breakEven << "%\n";
+    std::cout << "EV of calling: " << decision.callEv << " chips (" << decision.callEv / Settings::bigBlind
+        << " big blinds)\n";
+    std::cout << (decision.call ? "Call" : "Fold");
+    if (!decision.clear)
     {
-        usedCards.push_back(players.data()[i].hand[0]);
-        usedCards.push_back(players.data()[i].hand[1]);
+        std::cout << " (too close to call within the margin)";
     }
-    for (std::size_t i {0}; i < static_cast<std::size_t>(numCommunal); ++i)
+    std::cout << '\n';
+}
+
+// Set by Ctrl-C while runTests() is calculating
+static std::atomic<bool> interrupted {false};
+
+static void interrupt(int)
+{
+    interrupted.store(true);
+}
+
+void runTests(int tries, unsigned threads, std::uint64_t seed, const PreflopTable* preflop, double precision,
+    EquityCache* cache, PotOdds odds, const Sampling& sampling, std::chrono::milliseconds progressInterval,
+    std::chrono::milliseconds timeLimit)
+{
+    auto scenario {askScenario()};
+    Xoshiro256 rng {seed};
+
+    if (odds.toCall > 0)
     {
-        usedCards.push_back(communalCards.data()[i]);
+        auto quick {quickDecision(scenario, odds, rng, preflop, cache)};
+        std::cout << "Quick estimate: " << 100 * quick.equity << "% +/- " << 100 * quick.margin << "%\n";
+        printDecision(quick);
     }
 
-    for (int n {0}; n<tries; ++n)
-    {
-        deck.shuffle(usedCards);
+    std::string key {cache ? EquityCache::key(scenario) : std::string {}};
+    auto cached {cache ? cache->find(key, tries, precision) : std::nullopt};
 
-        for (int i {numHands}; i<numPlayers; ++i)
+    // The time limit starts once the scenario is known, and Ctrl-C ends the run early rather than the program
+    RunControl control {};
+    control.cancel = &interrupted;
+    if (timeLimit.count() > 0)
+    {
+        control.deadline = RunControl::Clock::now() + timeLimit;
+    }
+    if (progressInterval.count() > 0)
+    {
+        control.progressInterval = progressInterval;
+        control.onProgress = [](const EquityResult& sofar)
         {
-            players.data()[i] = Player {deck.dealCard(), deck.dealCard()};
-        }
-        players.data()[0].isPlayer = true;
+            std::cout << "After " << sofar.trials << " trials: " << 100 * sofar.equity() << "% +/- "
+                << 100 * sofar.margin() << "%\n" << std::flush;
+        };
+    }
+    interrupted.store(false);
+    auto previousHandler {std::signal(SIGINT, interrupt)};
+
+    // With a bet to call, the full calculation is the decision's accurate tier, refining the quick estimate above
+    // in the background. The cache is left to this function, as for any other run.
+    auto allocationsBefore {AllocationCount::total()};
+    std::optional<CallDecision> refined {};
+    if (!cached && odds.toCall > 0)
+    {
+        auto accurate {accurateDecision(scenario, odds, precision, tries, threads, rng, preflop, nullptr, sampling,
+            control)};
+        refined = accurate.get();
+    }
+    auto result {cached ? *cached : refined ? refined->result :
+        precision > 0 ? calculateToPrecision(scenario, precision, tries, threads, rng, preflop, 1.96, sampling, control) :
+        calculate(scenario, tries, threads, rng, preflop, sampling, control)};
+    auto allocations {AllocationCount::total() - allocationsBefore};
 
-        for (int i {numCommunal}; i<5; ++i)
-        {
-            communalCards.data()[i] = deck.dealCard();
-        }
+    std::signal(SIGINT, previousHandler);
 
-        auto gameRes {checkWinner(players, communalCards)};
+    if (cached)
+    {
+        std::cout << "Answered from the cache\n";
+    }
+    else if (cache && !result.stopped)
+    {
+        cache->insert(key, result);
+    }
+    auto wins {result.wins};
+    auto draws {result.draws};
+    auto trials {result.trials};
 
-        if (gameRes == Settings::win)
-        {
-            ++wins;
-        }
-        else if (gameRes == Settings::draw)
-        {
-            ++draws;
-        }
+    if (trials == 0)
+    {
+        std::cout << "No runouts are possible: the ranges cannot all be dealt a hand once the known cards are removed\n";
+        return;
+    }
+
+    if (result.stopped)
+    {
+        std::cout << "Stopped early after " << trials << " trials\n";
+    }
+
+    if (result.method == EquityResult::preflop_table)
+    {
+        std::cout << "Exact preflop result for these starting hand classes\n";
+    }
+    else if (result.method == EquityResult::exact)
+    {
+        std::cout << "Exact result over all " << trials << " runouts\n";
     }
 
     std::cout << "Wins: " << wins << '\n';
     std::cout << "Draws: " << draws << '\n';
-    std::cout << "Losses: " << tries-wins-draws << '\n';
-    std::cout << "Win rate: " << 100 * static_cast<double>(wins)/tries << "%\n";
-    std::cout << "Draw rate: " << 100 * static_cast<double>(draws)/tries << "%\n";
-    std::cout << "Loss rate: " << 100 * static_cast<double>(tries-wins-draws)/tries << "%\n";
+    std::cout << "Losses: " << trials-wins-draws << '\n';
+    std::cout << "Win rate: " << 100 * static_cast<double>(wins)/trials << "%\n";
+    std::cout << "Draw rate: " << 100 * static_cast<double>(draws)/trials << "%\n";
+    std::cout << "Loss rate: " << 100 * static_cast<double>(trials-wins-draws)/trials << "%\n";
+    std::cout << "Equity: " << 100 * result.equity() << "% +/- " << 100 * result.margin() << "% (95%)\n";
+
+    if (AllocationCount::enabled)
+    {
+        std::cout << "Heap allocations: " << allocations << " (" << static_cast<double>(allocations) / trials
+            << " per trial)\n";
+    }
+
+    for (int seat {0}; seat < static_cast<int>(result.seatShares.size()); ++seat)
+    {
+        std::cout << "Seat " << seat + 1 << " equity: " << 100 * result.seatEquity(seat) << "%\n";
+    }
+
+    if (odds.toCall > 0)
+    {
+        std::cout << "Refined decision:\n";
+        printDecision(refined ? *refined : decide(result, odds));
+    }
 
 }
 
-int main()
+void runOuts(int tries, unsigned threads, std::uint64_t seed)
 {
-    runTests(1000);
+    auto scenario {askScenario()};
+    if (scenario.numHands == 0 || scenario.numCommunal < 3 || scenario.numCommunal > 4)
+    {
+        std::cout << "The outs report needs your hand and a flop or turn\n";
+        return;
+    }
+
+    Xoshiro256 rng {seed};
+    auto report {outsReport(scenario, tries, threads, rng)};
+    if (report.current.trials == 0)
+    {
+        std::cout << "No runouts are possible: the ranges cannot all be dealt a hand once the known cards are removed\n";
+        return;
+    }
+
+    std::cout << "Equity now: " << 100 * report.current.equity() << "%\n";
+    std::cout << "Equity after each next card:\n";
+    for (const auto& next : report.nextCards)
+    {
+        std::cout << next.card << ": " << 100 * next.result.equity() << "% (" << next.madeHand << ")\n";
+    }
+
+    std::cout << "Outs by the hand they make:\n";
+    for (auto ranking : Settings::allRankings)
+    {
+        const auto& cards {report.outs[ranking]};
+        if (cards.empty())
+        {
+            continue;
+        }
 
-    return 0;
-}
\ No newline at end of file
+        std::cout << ranking << " (" << cards.size() << "):";
+        for (auto card : cards)
+        {
+            std::cout << ' ' << card;
+        }
+        std::cout << '\n';
+    }
+}
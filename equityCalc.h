@@ -1,21 +1,54 @@
 #pragma once
 
+#include <chrono>
+#include <cstdint>
 #include <utility>
 #include <vector>
-#include <functional>
 #include "pokerGame.h"
 #include "deck.h"
+#include "range.h"
+#include "preflopTable.h"
+#include "equityCache.h"
+#include "decision.h"
 
 std::pair<int, std::vector<Player>> getHands(int numPlayers);
-std::pair<int, std::vector<Card>> getCommunalCards();
+std::vector<Range> getRanges(int numPlayers, int numHands);
+std::pair<int, CardSet> getCommunalCards();
 
 struct HandFunction
 {
-    using HandEvaluator = std::function<std::vector<Card>(std::vector<Card>)>;
+    using HandEvaluator = BestHand (*)(CardSet);
 
     HandEvaluator function;
     Settings::Rankings ranking;
 };
 
-Settings::GameStates checkWinner(std::vector<Player>& players, std::vector<Card>& communalCards);
-void runTests(int tries);
\ No newline at end of file
+// Runs the evaluator chain to fill in player.bestHand and player.handType
+void findBestHand(Player& player, CardSet communalCards);
+
+struct ShowdownResult
+{
+    Settings::GameStates state {Settings::loss};
+    int numWinners {0};
+};
+
+// The hero's result and how many players share the best hand
+ShowdownResult showdown(std::vector<Player>& players, CardSet communalCards);
+Settings::GameStates checkWinner(std::vector<Player>& players, CardSet communalCards);
+
+// Asks for the players, hands and board, then splits tries across threads workers, drawing from generators seeded
+// with seed so that the same seed and thread count repeat a run exactly.
+// Heads-up preflop spots are answered from preflop when one is given.
+// A positive precision samples until the 95% interval on equity is that narrow, with tries as the limit.
+// Results are looked up in and added to cache when one is given. With a call amount in odds, a quick estimate of
+// the call decision is printed first and the full result is followed by the accurate decision. Sampled results are
+// drawn as sampling says. A positive progressInterval prints the equity so far that often while sampling, a positive
+// timeLimit stops sampling that long after the scenario is entered, and Ctrl-C stops it at once; either way the
+// trials finished so far are reported.
+void runTests(int tries, unsigned threads, std::uint64_t seed, const PreflopTable* preflop = nullptr,
+    double precision = 0, EquityCache* cache = nullptr, PotOdds odds = {}, const Sampling& sampling = {},
+    std::chrono::milliseconds progressInterval = {}, std::chrono::milliseconds timeLimit = {});
+
+// Asks for a scenario on the flop or turn and prints the hero's equity after every possible next card, with the
+// outs grouped by the hand they make. tries is the sample size per card when the spot is too big to enumerate.
+void runOuts(int tries, unsigned threads, std::uint64_t seed);
\ No newline at end of file
@@ -0,0 +1,195 @@
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <string_view>
+#include "deck.h"
+#include "equityCalc.h"
+#include "handStrength.h"
+#include "pokerGame.h"
+#include "rng.h"
+
+// Checks HandStrength::evaluate and the findBestHand() chain it replaced against a fixed table of hands whose
+// categories and order are known, then against each other: on random pairs of hands sharing a board of three to five
+// cards, both must give each hand the same category and order the two hands the same way.
+// Exits with 1 and prints the first disagreements if they do not.
+namespace
+{
+    using Settings::Rankings;
+
+    // Two hands on a shared board, their categories and which is better: 1 the first, -1 the second, 0 a split
+    struct Known
+    {
+        std::string_view board {};
+        std::string_view first {};
+        std::string_view second {};
+        Rankings firstCategory {};
+        Rankings secondCategory {};
+        int order {};
+    };
+
+    constexpr Known knownHands[]
+    {
+        // The wheel is the lowest straight, and a six-card run plays its top five
+        {"3c4d5h9sKc", "Ad2c", "6d2h", Settings::straight, Settings::straight, -1},
+        {"2c3d4h5s6c", "7d8d", "Ac9d", Settings::straight, Settings::straight, 1},
+        {"AsKsQsJsTs", "2h3d", "4c5d", Settings::straight_flush, Settings::straight_flush, 0},
+        {"5h6h7h8c8d", "4h3h", "8s8h", Settings::straight_flush, Settings::four_kind, 1},
+        {"9c9d9h9s2c", "Ah3d", "Kh3c", Settings::four_kind, Settings::four_kind, 1},
+        {"9c9d9h9sAc", "Kh3d", "Qh3c", Settings::four_kind, Settings::four_kind, 0},
+        {"7c7d7h2s2c", "AsAd", "KsKd", Settings::full_house, Settings::full_house, 1},
+        {"KhKd9h4h2c", "9c9d", "Ah5h", Settings::full_house, Settings::flush, 1},
+        {"Ah9h5h2hKc", "Qh3c", "Jh8h", Settings::flush, Settings::flush, 1},
+        {"9h8h7c2h3d", "Th6s", "Ah4h", Settings::straight, Settings::flush, -1},
+        {"8s8d4c3hKd", "8cJc", "4h3s", Settings::three_kind, Settings::two_pair, 1},
+        // Two pair is decided by the fifth card, and a third pair on the board can counterfeit a hand's low pair
+        {"KsKdQhQc2s", "Ah3d", "Jh3c", Settings::two_pair, Settings::two_pair, 1},
+        {"KsKdQhQcAs", "2h3d", "4c5d", Settings::two_pair, Settings::two_pair, 0},
+        {"QsQd8c8h4s", "Ac2d", "5c5d", Settings::two_pair, Settings::two_pair, 1},
+        {"AsTd7c4h2s", "Ah9c", "Ac8d", Settings::pair, Settings::pair, 1},
+        {"AsTd7c4h", "Ah9c", "Ad9d", Settings::pair, Settings::pair, 0},
+        {"KdTc7s", "Ah2c", "Qh9d", Settings::high_card, Settings::high_card, 1},
+    };
+
+    constexpr int numPairs {1000000};
+    constexpr int maxReported {10};
+
+    // Half the pairs come from the full deck; the rest from two suits of six values or four suits of three, where
+    // straights, flushes, full houses and quads are common enough to be checked thoroughly
+    CardCode drawCode(Xoshiro256& rng, int deckKind, std::uint32_t firstValue)
+    {
+        if (deckKind == 0)
+        {
+            return static_cast<CardCode>(rng.below(52));
+        }
+
+        std::uint32_t suits {(deckKind == 1) ? 2u : 4u};
+        std::uint32_t values {(deckKind == 1) ? 6u : 3u};
+        auto suit {rng.below(suits)};
+        auto value {(firstValue + rng.below(values)) % Card::max_ranks};
+        return static_cast<CardCode>(suit * Card::max_ranks + value);
+    }
+
+    CardSet drawCards(Xoshiro256& rng, int count, CardSet& used, int deckKind, std::uint32_t firstValue)
+    {
+        CardSet cards {};
+        while (cards.size() < count)
+        {
+            CardSet card {CardSet::bit(drawCode(rng, deckKind, firstValue))};
+            if (!card.intersects(used))
+            {
+                cards = cards | card;
+                used = used | card;
+            }
+        }
+        return cards;
+    }
+
+    void printCards(CardSet cards)
+    {
+        cards.forEach([](Card card) { std::cout << card; });
+    }
+
+    // -1, 0 or 1 as first is worse than, as good as or better than second
+    template <typename T>
+    int compare(const T& first, const T& second)
+    {
+        return (first < second) ? -1 : (second < first) ? 1 : 0;
+    }
+}
+
+int main()
+{
+    int failures {0};
+    for (const auto& known : knownHands)
+    {
+        auto board {*CardSet::fromString(known.board)};
+        std::array<Player, 2> players {};
+        players[0].hand = *CardSet::fromString(known.first);
+        players[1].hand = *CardSet::fromString(known.second);
+
+        std::array<HandStrength::Strength, 2> strengths {};
+        for (std::size_t seat {0}; seat < players.size(); ++seat)
+        {
+            findBestHand(players[seat], board);
+            strengths[seat] = HandStrength::evaluate(board | players[seat].hand);
+        }
+
+        bool evaluateRight {HandStrength::category(strengths[0]) == known.firstCategory &&
+            HandStrength::category(strengths[1]) == known.secondCategory &&
+            compare(strengths[0], strengths[1]) == known.order};
+        bool chainRight {players[0].handType == known.firstCategory && players[1].handType == known.secondCategory &&
+            compare(players[0], players[1]) == known.order};
+        if (!evaluateRight || !chainRight)
+        {
+            ++failures;
+            std::cout << "On board " << known.board << ", " << known.first << " against " << known.second
+                << " should be " << known.firstCategory << " against " << known.secondCategory << " with order "
+                << known.order << ", but evaluate gives " << HandStrength::category(strengths[0]) << " against "
+                << HandStrength::category(strengths[1]) << " with order " << compare(strengths[0], strengths[1])
+                << " and findBestHand " << players[0].handType << " against " << players[1].handType
+                << " with order " << compare(players[0], players[1]) << '\n';
+        }
+    }
+
+    Xoshiro256 rng {20240613};
+    std::array<std::int64_t, Settings::max_rankings> categories {};
+
+    for (int n {0}; n < numPairs; ++n)
+    {
+        int deckKind {(n % 2 == 0) ? 0 : (n % 4 == 1) ? 1 : 2};
+        auto firstValue {rng.below(Card::max_ranks)};
+        CardSet used {};
+        auto board {drawCards(rng, 3 + static_cast<int>(rng.below(3)), used, deckKind, firstValue)};
+
+        std::array<Player, 2> players {};
+        std::array<HandStrength::Strength, 2> strengths {};
+        for (std::size_t seat {0}; seat < players.size(); ++seat)
+        {
+            players[seat].hand = drawCards(rng, 2, used, deckKind, firstValue);
+            findBestHand(players[seat], board);
+            strengths[seat] = HandStrength::evaluate(board | players[seat].hand);
+            ++categories[players[seat].handType];
+        }
+
+        bool sameCategories {HandStrength::category(strengths[0]) == players[0].handType &&
+            HandStrength::category(strengths[1]) == players[1].handType};
+        if (sameCategories && compare(strengths[0], strengths[1]) == compare(players[0], players[1]))
+        {
+            continue;
+        }
+
+        if (++failures <= maxReported)
+        {
+            std::cout << "Disagreement on board ";
+            printCards(board);
+            for (const auto& player : players)
+            {
+                std::cout << ", hand ";
+                printCards(player.hand);
+                std::cout << " is " << player.handType;
+            }
+            std::cout << " by findBestHand but " << HandStrength::category(strengths[0]) << " and "
+                << HandStrength::category(strengths[1]) << " with strengths " << strengths[0] << " and "
+                << strengths[1] << '\n';
+        }
+    }
+
+    for (auto ranking : Settings::allRankings)
+    {
+        std::cout << ranking << ": " << categories[ranking] << '\n';
+        if (categories[ranking] == 0)
+        {
+            std::cout << "No " << ranking << " was dealt\n";
+            ++failures;
+        }
+    }
+
+    if (failures > 0)
+    {
+        std::cout << failures << " checks failed\n";
+        return 1;
+    }
+
+    std::cout << "All " << std::size(knownHands) << " known hands and " << numPairs << " pairs of hands agree\n";
+    return 0;
+}
@@ -0,0 +1,671 @@
+#include <array>
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+#include "deck.h"
+#include "pokerGame.h"
+#include "profile.h"
+#include "handStrength.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define VECTOR_KERNELS
+#include <immintrin.h>
+#endif
+
+// Hands without a flush are looked up by how many cards of each value they hold. The counts form a base-5 word
+// of 13 digits whose digits sum to the number of cards, and such words are numbered lexicographically so each
+// card count gets a dense table: with offset[v][c][k] = the number of words that have a digit below c at value v
+// when k cards remain for values v and above, a hand's index is the sum of offset[v][count][remaining].
+static constexpr int maxCards {7};
+static constexpr int minCards {5};
+static constexpr int maxCount {4};
+
+// The vector kernels read the uint16 tables 32 bits at a time, so each ends with one spare entry
+struct Tables
+{
+    std::array<HandStrength::Strength, CardSet::suitBits + 2> flush {};
+    std::array<std::array<std::array<std::uint32_t, maxCards + 1>, maxCount + 1>, Card::max_ranks> offset {};
+    std::array<std::vector<HandStrength::Strength>, maxCards - minCards + 1> noFlush {};
+};
+
+// Category in bits 20 and up, then up to five deciding values of four bits each, most significant first
+static std::uint32_t rawScore(Settings::Rankings ranking, std::initializer_list<int> values)
+{
+    std::uint32_t score {static_cast<std::uint32_t>(ranking)};
+    int shift {5};
+    for (auto value : values)
+    {
+        score = (score << 4) | static_cast<std::uint32_t>(value);
+        --shift;
+    }
+    return score << (4 * shift);
+}
+
+static int highestValue(std::uint16_t values)
+{
+    return std::bit_width(values) - 1;
+}
+
+// The top count values of values, highest first, packed as in rawScore
+static std::uint32_t topValues(std::uint16_t values, int count)
+{
+    std::uint32_t score {0};
+    for (int i {0}; i < 5; ++i)
+    {
+        score <<= 4;
+        if (i < count && values)
+        {
+            int value {highestValue(values)};
+            score |= static_cast<std::uint32_t>(value);
+            values &= static_cast<std::uint16_t>(~(1 << value));
+        }
+    }
+    return score;
+}
+
+static std::uint32_t flushScore(std::uint16_t suited)
+{
+    int high {straightHigh(suited)};
+    if (high >= 0)
+    {
+        return rawScore(Settings::straight_flush, {high});
+    }
+
+    return (std::uint32_t {Settings::flush} << 20) | topValues(suited, 5);
+}
+
+static std::uint32_t noFlushScore(const ValueMasks& values)
+{
+    auto without = [](std::uint16_t mask, int value) { return static_cast<std::uint16_t>(mask & ~(1 << value)); };
+
+    if (values.four)
+    {
+        int quads {highestValue(values.four)};
+        return rawScore(Settings::four_kind, {quads, highestValue(without(values.any, quads))});
+    }
+
+    if (values.atLeastThree)
+    {
+        int trips {highestValue(values.atLeastThree)};
+        auto pairs {without(values.atLeastTwo, trips)};
+        if (pairs)
+        {
+            return rawScore(Settings::full_house, {trips, highestValue(pairs)});
+        }
+    }
+
+    int high {straightHigh(values.any)};
+    if (high >= 0)
+    {
+        return rawScore(Settings::straight, {high});
+    }
+
+    if (values.atLeastThree)
+    {
+        int trips {highestValue(values.atLeastThree)};
+        return (std::uint32_t {Settings::three_kind} << 20) | (static_cast<std::uint32_t>(trips) << 16) |
+            (topValues(without(values.any, trips), 2) >> 4);
+    }
+
+    if (values.atLeastTwo)
+    {
+        int first {highestValue(values.atLeastTwo)};
+        auto otherPairs {without(values.atLeastTwo, first)};
+        if (otherPairs)
+        {
+            int second {highestValue(otherPairs)};
+            return rawScore(Settings::two_pair, {first, second, highestValue(without(without(values.any, first), second))});
+        }
+
+        return (std::uint32_t {Settings::pair} << 20) | (static_cast<std::uint32_t>(first) << 16) |
+            (topValues(without(values.any, first), 3) >> 4);
+    }
+
+    return (std::uint32_t {Settings::high_card} << 20) | topValues(values.any, 5);
+}
+
+// Calls func(counts) for every way of holding cards cards spread over the values, at most four per value
+template <typename Func>
+static void forEachCounts(std::array<int, Card::max_ranks>& counts, int value, int cards, Func& func)
+{
+    if (value == Card::max_ranks)
+    {
+        if (cards == 0)
+        {
+            func(counts);
+        }
+        return;
+    }
+
+    for (int count {0}; count <= std::min(cards, maxCount); ++count)
+    {
+        counts[static_cast<std::size_t>(value)] = count;
+        forEachCounts(counts, value + 1, cards - count, func);
+    }
+    counts[static_cast<std::size_t>(value)] = 0;
+}
+
+static std::uint32_t countsIndex(const Tables& tables, const std::array<int, Card::max_ranks>& counts, int cards)
+{
+    std::uint32_t index {0};
+    for (std::size_t value {0}; value < Card::max_ranks; ++value)
+    {
+        index += tables.offset[value][static_cast<std::size_t>(counts[value])][static_cast<std::size_t>(cards)];
+        cards -= counts[value];
+    }
+    return index;
+}
+
+static Tables buildTables()
+{
+    Tables tables {};
+
+    // words[n][k]: how many words of n digits sum to k
+    std::array<std::array<std::uint32_t, maxCards + 1>, Card::max_ranks + 1> words {};
+    words[0][0] = 1;
+    for (std::size_t n {1}; n <= Card::max_ranks; ++n)
+    {
+        for (std::size_t k {0}; k <= maxCards; ++k)
+        {
+            for (std::size_t digit {0}; digit <= std::min<std::size_t>(k, maxCount); ++digit)
+            {
+                words[n][k] += words[n - 1][k - digit];
+            }
+        }
+    }
+
+    for (std::size_t value {0}; value < Card::max_ranks; ++value)
+    {
+        std::size_t digitsAfter {Card::max_ranks - value - 1};
+        for (std::size_t k {0}; k <= maxCards; ++k)
+        {
+            for (std::size_t count {1}; count <= maxCount; ++count)
+            {
+                std::uint32_t below {tables.offset[value][count - 1][k]};
+                tables.offset[value][count][k] = below + ((count - 1 <= k) ? words[digitsAfter][k - (count - 1)] : 0);
+            }
+        }
+    }
+
+    // Score every reachable hand, then replace each score by its rank within its category
+    std::array<std::vector<std::uint32_t>, maxCards - minCards + 1> noFlushScores {};
+    std::vector<std::uint32_t> allScores {};
+
+    for (int cards {minCards}; cards <= maxCards; ++cards)
+    {
+        auto& scores {noFlushScores[static_cast<std::size_t>(cards - minCards)]};
+        scores.resize(words[Card::max_ranks][static_cast<std::size_t>(cards)]);
+
+        std::array<int, Card::max_ranks> counts {};
+        auto scoreCounts = [&](const std::array<int, Card::max_ranks>& held)
+        {
+            ValueMasks values {};
+            for (std::size_t value {0}; value < Card::max_ranks; ++value)
+            {
+                auto bit {static_cast<std::uint16_t>(1 << value)};
+                values.any |= (held[value] >= 1) ? bit : 0;
+                values.atLeastTwo |= (held[value] >= 2) ? bit : 0;
+                values.atLeastThree |= (held[value] >= 3) ? bit : 0;
+                values.four |= (held[value] >= 4) ? bit : 0;
+            }
+            scores[countsIndex(tables, held, cards)] = noFlushScore(values);
+        };
+        forEachCounts(counts, 0, cards, scoreCounts);
+
+        allScores.insert(allScores.end(), scores.begin(), scores.end());
+    }
+
+    std::array<std::uint32_t, CardSet::suitBits + 1> flushScores {};
+    for (std::uint32_t suited {0}; suited <= CardSet::suitBits; ++suited)
+    {
+        if (std::popcount(suited) >= minCards)
+        {
+            flushScores[suited] = flushScore(static_cast<std::uint16_t>(suited));
+            allScores.push_back(flushScores[suited]);
+        }
+    }
+
+    std::sort(allScores.begin(), allScores.end());
+    allScores.erase(std::unique(allScores.begin(), allScores.end()), allScores.end());
+
+    auto toStrength = [&](std::uint32_t score)
+    {
+        auto pos {std::lower_bound(allScores.begin(), allScores.end(), score)};
+        auto categoryStart {std::lower_bound(allScores.begin(), allScores.end(), score & ~0xFFFFFu)};
+        auto ranking {score >> 20};
+        return static_cast<HandStrength::Strength>((ranking << HandStrength::categoryShift) | 
+            static_cast<std::uint32_t>(pos - categoryStart));
+    };
+
+    for (std::size_t i {0}; i < noFlushScores.size(); ++i)
+    {
+        tables.noFlush[i].reserve(noFlushScores[i].size());
+        for (auto score : noFlushScores[i])
+        {
+            tables.noFlush[i].push_back(toStrength(score));
+        }
+        tables.noFlush[i].push_back(0);
+    }
+
+    for (std::size_t suited {0}; suited <= CardSet::suitBits; ++suited)
+    {
+        if (flushScores[suited])
+        {
+            tables.flush[suited] = toStrength(flushScores[suited]);
+        }
+    }
+
+    return tables;
+}
+
+static const Tables& tables()
+{
+    static const Tables built {buildTables()};
+    return built;
+}
+
+static HandStrength::Strength noFlushStrength(const Tables& t, unsigned any, unsigned atLeastTwo,
+    unsigned atLeastThree, unsigned four, int numCards)
+{
+    // Values with no cards add nothing to the index, so only the values held need visiting
+    std::uint32_t index {0};
+    auto remaining {static_cast<std::size_t>(numCards)};
+    for (unsigned rest {any}; rest; rest &= rest - 1)
+    {
+        auto value {static_cast<unsigned>(std::countr_zero(rest))};
+        std::size_t count {1 + ((atLeastTwo >> value) & 1) + ((atLeastThree >> value) & 1) + ((four >> value) & 1)};
+        index += t.offset[value][count][remaining];
+        remaining -= count;
+    }
+
+    return t.noFlush[static_cast<std::size_t>(numCards - minCards)][index];
+}
+
+HandStrength::Strength HandStrength::evaluate(CardSet cards)
+{
+    const Tables& t {tables()};
+
+    auto c {cards.suitMask(Card::suit_clubs)};
+    auto d {cards.suitMask(Card::suit_diamonds)};
+    auto h {cards.suitMask(Card::suit_hearts)};
+    auto s {cards.suitMask(Card::suit_spades)};
+
+    // With at most seven cards a flush rules out quads and full houses, so it is the best hand available
+    for (auto suited : {c, d, h, s})
+    {
+        if (std::popcount(suited) >= minCards)
+        {
+            return t.flush[suited];
+        }
+    }
+
+    auto any {static_cast<unsigned>(c | d | h | s)};
+    auto atLeastTwo {static_cast<unsigned>((c & d) | (c & h) | (c & s) | (d & h) | (d & s) | (h & s))};
+    auto atLeastThree {static_cast<unsigned>((c & d & h) | (c & d & s) | (c & h & s) | (d & h & s))};
+    auto four {static_cast<unsigned>(c & d & h & s)};
+
+    int numCards {cards.size()};
+    assert(numCards >= minCards && numCards <= maxCards && "HandStrength::evaluate takes 5 to 7 cards");
+
+    return noFlushStrength(t, any, atLeastTwo, atLeastThree, four, numCards);
+}
+
+HandStrength::Board::Board(CardSet cards)
+: m_numCards {cards.size()}
+{
+    assert(m_numCards + 2 >= minCards && m_numCards + 2 <= maxCards && "HandStrength::Board takes 3 to 5 cards");
+
+    for (int suit {0}; suit < Card::max_suits; ++suit)
+    {
+        auto suited {cards.suitMask(suit)};
+        m_four |= static_cast<std::uint16_t>(m_atLeastThree & suited);
+        m_atLeastThree |= static_cast<std::uint16_t>(m_atLeastTwo & suited);
+        m_atLeastTwo |= static_cast<std::uint16_t>(m_any & suited);
+        m_any |= suited;
+
+        if (std::popcount(suited) >= minCards - 2)
+        {
+            m_flushSuit = suit;
+            m_flushCards = suited;
+        }
+    }
+}
+
+HandStrength::Strength HandStrength::Board::evaluate(CardSet hole) const
+{
+    const Tables& t {tables()};
+
+    if (m_flushSuit >= 0)
+    {
+        auto suited {static_cast<std::uint16_t>(m_flushCards | hole.suitMask(m_flushSuit))};
+        if (std::popcount(suited) >= minCards)
+        {
+            return t.flush[suited];
+        }
+    }
+
+    unsigned any {m_any};
+    unsigned atLeastTwo {m_atLeastTwo};
+    unsigned atLeastThree {m_atLeastThree};
+    unsigned four {m_four};
+    for (std::uint64_t rest {hole.mask}; rest; rest &= rest - 1)
+    {
+        unsigned bit {1u << (std::countr_zero(rest) % Card::max_ranks)};
+        four |= atLeastThree & bit;
+        atLeastThree |= atLeastTwo & bit;
+        atLeastTwo |= any & bit;
+        any |= bit;
+    }
+
+    return noFlushStrength(t, any, atLeastTwo, atLeastThree, four, m_numCards + hole.size());
+}
+
+static void evaluateScalar(const HandStrength::SevenCardColumns& cards, std::size_t first, std::size_t count,
+    HandStrength::Strength* strengths)
+{
+    for (std::size_t n {first}; n < count; ++n)
+    {
+        CardSet hand {};
+        for (const auto* column : cards)
+        {
+            hand.mask |= CardSet::bit(column[n]);
+        }
+        strengths[n] = HandStrength::evaluate(hand);
+    }
+}
+
+#ifdef VECTOR_KERNELS
+
+// The vector kernels follow evaluate() lane by lane. Each card adds its value bit to the any, atLeastTwo,
+// atLeastThree and four masks as in Board::evaluate and one to its suit's byte of a packed count. The no-flush
+// index then visits the values held lowest first, gathering offset[value][count][remaining] for every lane at
+// once, and a suit's byte reaching five marks the lanes whose result comes from the flush table instead.
+static const std::uint32_t* flatOffsets(const Tables& t)
+{
+    static_assert(sizeof(Tables::offset) == sizeof(std::uint32_t) * Card::max_ranks * (maxCount + 1) * (maxCards + 1));
+    return t.offset.front().front().data();
+}
+
+constexpr int offsetValueStride {(maxCount + 1) * (maxCards + 1)};
+constexpr int offsetCountStride {maxCards + 1};
+
+// Adding 0x7B to a byte holding at most seven sets its top bit exactly when it holds five or more
+constexpr int flushCountBias {0x7B7B7B7B};
+constexpr int flushCountTop {static_cast<int>(0x80808080)};
+
+__attribute__((target("avx2")))
+static std::size_t evaluateAvx2(const Tables& t, const HandStrength::SevenCardColumns& cards, std::size_t count,
+    HandStrength::Strength* strengths)
+{
+    const auto* offsets {reinterpret_cast<const int*>(flatOffsets(t))};
+    const auto* noFlush {reinterpret_cast<const int*>(t.noFlush[maxCards - minCards].data())};
+    const auto* flush {reinterpret_cast<const int*>(t.flush.data())};
+
+    const __m256i zero {_mm256_setzero_si256()};
+    const __m256i one {_mm256_set1_epi32(1)};
+    const __m256i thirteen {_mm256_set1_epi32(Card::max_ranks)};
+    const __m256i low16 {_mm256_set1_epi32(0xFFFF)};
+
+    std::size_t n {0};
+    for (; n + 8 <= count; n += 8)
+    {
+        __m256i any {zero};
+        __m256i atLeastTwo {zero};
+        __m256i atLeastThree {zero};
+        __m256i four {zero};
+        __m256i suitCounts {zero};
+        __m256i bits[7];
+        __m256i suitShifts[7];
+
+        for (std::size_t i {0}; i < cards.size(); ++i)
+        {
+            __m256i code {_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(cards[i] + n)))};
+            // code * 20 / 256 is code / 13 for every card code
+            __m256i suit {_mm256_srli_epi32(_mm256_add_epi32(_mm256_slli_epi32(code, 4), _mm256_slli_epi32(code, 2)), 8)};
+            __m256i bit {_mm256_sllv_epi32(one, _mm256_sub_epi32(code, _mm256_mullo_epi32(suit, thirteen)))};
+
+            four = _mm256_or_si256(four, _mm256_and_si256(atLeastThree, bit));
+            atLeastThree = _mm256_or_si256(atLeastThree, _mm256_and_si256(atLeastTwo, bit));
+            atLeastTwo = _mm256_or_si256(atLeastTwo, _mm256_and_si256(any, bit));
+            any = _mm256_or_si256(any, bit);
+
+            bits[i] = bit;
+            suitShifts[i] = _mm256_slli_epi32(suit, 3);
+            suitCounts = _mm256_add_epi32(suitCounts, _mm256_sllv_epi32(one, suitShifts[i]));
+        }
+
+        __m256i index {zero};
+        __m256i remaining {_mm256_set1_epi32(maxCards)};
+        for (__m256i rest {any}; !_mm256_testz_si256(rest, rest);)
+        {
+            // A power of two converted to float has its position as the exponent
+            __m256i lowest {_mm256_and_si256(rest, _mm256_sub_epi32(zero, rest))};
+            __m256i value {_mm256_sub_epi32(_mm256_srli_epi32(_mm256_castps_si256(_mm256_cvtepi32_ps(lowest)), 23),
+                _mm256_set1_epi32(127))};
+            __m256i held {_mm256_add_epi32(one, _mm256_add_epi32(_mm256_and_si256(_mm256_srlv_epi32(atLeastTwo, value), one),
+                _mm256_add_epi32(_mm256_and_si256(_mm256_srlv_epi32(atLeastThree, value), one),
+                _mm256_and_si256(_mm256_srlv_epi32(four, value), one))))};
+            __m256i slot {_mm256_add_epi32(_mm256_add_epi32(_mm256_mullo_epi32(value, _mm256_set1_epi32(offsetValueStride)),
+                _mm256_mullo_epi32(held, _mm256_set1_epi32(offsetCountStride))), remaining)};
+
+            index = _mm256_add_epi32(index,
+                _mm256_mask_i32gather_epi32(zero, offsets, slot, _mm256_cmpgt_epi32(lowest, zero), 4));
+            remaining = _mm256_sub_epi32(remaining, held);
+            rest = _mm256_xor_si256(rest, lowest);
+        }
+
+        __m256i strength {_mm256_and_si256(_mm256_i32gather_epi32(noFlush, index, 2), low16)};
+
+        __m256i flushTops {_mm256_and_si256(_mm256_add_epi32(suitCounts, _mm256_set1_epi32(flushCountBias)),
+            _mm256_set1_epi32(flushCountTop))};
+        if (!_mm256_testz_si256(flushTops, flushTops))
+        {
+            __m256i suited {zero};
+            for (std::size_t i {0}; i < cards.size(); ++i)
+            {
+                __m256i offSuit {_mm256_cmpeq_epi32(_mm256_and_si256(_mm256_sllv_epi32(_mm256_set1_epi32(0x80),
+                    suitShifts[i]), flushTops), zero)};
+                suited = _mm256_or_si256(suited, _mm256_andnot_si256(offSuit, bits[i]));
+            }
+
+            __m256i isFlush {_mm256_cmpgt_epi32(suited, zero)};
+            __m256i flushStrength {_mm256_and_si256(_mm256_mask_i32gather_epi32(zero, flush, suited, isFlush, 2), low16)};
+            strength = _mm256_blendv_epi8(strength, flushStrength, isFlush);
+        }
+
+        __m256i packed {_mm256_permute4x64_epi64(_mm256_packus_epi32(strength, strength), 0b1000)};
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(strengths + n), _mm256_castsi256_si128(packed));
+    }
+    return n;
+}
+
+// GCC 12 reports its own _mm512_undefined_epi32() as maybe uninitialized once the intrinsics are inlined here
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+__attribute__((target("avx512f")))
+static std::size_t evaluateAvx512(const Tables& t, const HandStrength::SevenCardColumns& cards, std::size_t count,
+    HandStrength::Strength* strengths)
+{
+    const auto* offsets {reinterpret_cast<const int*>(flatOffsets(t))};
+    const auto* noFlush {reinterpret_cast<const int*>(t.noFlush[maxCards - minCards].data())};
+    const auto* flush {reinterpret_cast<const int*>(t.flush.data())};
+
+    const __m512i zero {_mm512_setzero_si512()};
+    const __m512i one {_mm512_set1_epi32(1)};
+    const __m512i thirteen {_mm512_set1_epi32(Card::max_ranks)};
+    const __m512i low16 {_mm512_set1_epi32(0xFFFF)};
+
+    std::size_t n {0};
+    for (; n + 16 <= count; n += 16)
+    {
+        __m512i any {zero};
+        __m512i atLeastTwo {zero};
+        __m512i atLeastThree {zero};
+        __m512i four {zero};
+        __m512i suitCounts {zero};
+        __m512i bits[7];
+        __m512i suitShifts[7];
+
+        for (std::size_t i {0}; i < cards.size(); ++i)
+        {
+            __m512i code {_mm512_cvtepu8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(cards[i] + n)))};
+            __m512i suit {_mm512_srli_epi32(_mm512_add_epi32(_mm512_slli_epi32(code, 4), _mm512_slli_epi32(code, 2)), 8)};
+            __m512i bit {_mm512_sllv_epi32(one, _mm512_sub_epi32(code, _mm512_mullo_epi32(suit, thirteen)))};
+
+            four = _mm512_or_si512(four, _mm512_and_si512(atLeastThree, bit));
+            atLeastThree = _mm512_or_si512(atLeastThree, _mm512_and_si512(atLeastTwo, bit));
+            atLeastTwo = _mm512_or_si512(atLeastTwo, _mm512_and_si512(any, bit));
+            any = _mm512_or_si512(any, bit);
+
+            bits[i] = bit;
+            suitShifts[i] = _mm512_slli_epi32(suit, 3);
+            suitCounts = _mm512_add_epi32(suitCounts, _mm512_sllv_epi32(one, suitShifts[i]));
+        }
+
+        __m512i index {zero};
+        __m512i remaining {_mm512_set1_epi32(maxCards)};
+        __m512i rest {any};
+        for (__mmask16 live {_mm512_test_epi32_mask(rest, rest)}; live; live = _mm512_test_epi32_mask(rest, rest))
+        {
+            __m512i lowest {_mm512_and_si512(rest, _mm512_sub_epi32(zero, rest))};
+            __m512i value {_mm512_sub_epi32(_mm512_srli_epi32(_mm512_castps_si512(_mm512_cvtepi32_ps(lowest)), 23),
+                _mm512_set1_epi32(127))};
+            __m512i held {_mm512_add_epi32(one, _mm512_add_epi32(_mm512_and_si512(_mm512_srlv_epi32(atLeastTwo, value), one),
+                _mm512_add_epi32(_mm512_and_si512(_mm512_srlv_epi32(atLeastThree, value), one),
+                _mm512_and_si512(_mm512_srlv_epi32(four, value), one))))};
+            __m512i slot {_mm512_add_epi32(_mm512_add_epi32(_mm512_mullo_epi32(value, _mm512_set1_epi32(offsetValueStride)),
+                _mm512_mullo_epi32(held, _mm512_set1_epi32(offsetCountStride))), remaining)};
+
+            index = _mm512_add_epi32(index, _mm512_mask_i32gather_epi32(zero, live, slot, offsets, 4));
+            remaining = _mm512_sub_epi32(remaining, held);
+            rest = _mm512_xor_si512(rest, lowest);
+        }
+
+        __m512i strength {_mm512_i32gather_epi32(index, noFlush, 2)};
+
+        __m512i flushTops {_mm512_and_si512(_mm512_add_epi32(suitCounts, _mm512_set1_epi32(flushCountBias)),
+            _mm512_set1_epi32(flushCountTop))};
+        if (__mmask16 isFlush {_mm512_test_epi32_mask(flushTops, flushTops)}; isFlush)
+        {
+            __m512i suited {zero};
+            for (std::size_t i {0}; i < cards.size(); ++i)
+            {
+                __mmask16 onSuit {_mm512_test_epi32_mask(_mm512_sllv_epi32(_mm512_set1_epi32(0x80), suitShifts[i]),
+                    flushTops)};
+                suited = _mm512_mask_or_epi32(suited, onSuit, suited, bits[i]);
+            }
+            strength = _mm512_mask_i32gather_epi32(strength, isFlush, suited, flush, 2);
+        }
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(strengths + n), _mm512_cvtepi32_epi16(_mm512_and_si512(strength, low16)));
+    }
+    return n;
+}
+#pragma GCC diagnostic pop
+
+#endif
+
+const char* HandStrength::kernelName(Kernel kernel)
+{
+    static constexpr std::array names {"scalar", "avx2", "avx512"};
+    return names[kernel];
+}
+
+bool HandStrength::supported(Kernel kernel)
+{
+    switch (kernel)
+    {
+#ifdef VECTOR_KERNELS
+        case kernel_avx2:
+            return __builtin_cpu_supports("avx2");
+        case kernel_avx512:
+            return __builtin_cpu_supports("avx512f");
+#endif
+        case kernel_scalar:
+            return true;
+        default:
+            return false;
+    }
+}
+
+HandStrength::Kernel HandStrength::bestKernel()
+{
+    static const Kernel best {supported(kernel_avx512) ? kernel_avx512 : supported(kernel_avx2) ? kernel_avx2 :
+        kernel_scalar};
+    return best;
+}
+
+void HandStrength::evaluate(const SevenCardColumns& cards, std::size_t count, Strength* strengths, Kernel kernel)
+{
+    std::size_t done {0};
+#ifdef VECTOR_KERNELS
+    if (kernel == kernel_avx512 && supported(kernel_avx512))
+    {
+        done = evaluateAvx512(tables(), cards, count, strengths);
+    }
+    else if (kernel != kernel_scalar && supported(kernel_avx2))
+    {
+        done = evaluateAvx2(tables(), cards, count, strengths);
+    }
+#endif
+
+    // The hands left over after the last full vector
+    evaluateScalar(cards, done, count, strengths);
+}
+
+void HandStrength::Batch::clear()
+{
+    for (auto& column : m_cards)
+    {
+        column.clear();
+    }
+}
+
+void HandStrength::Batch::setBoard(CardSet board)
+{
+    assert(board.size() == 5 && "HandStrength::Batch takes complete boards");
+
+    std::size_t i {0};
+    for (std::uint64_t rest {board.mask}; rest; rest &= rest - 1)
+    {
+        m_board[i++] = static_cast<CardCode>(std::countr_zero(rest));
+    }
+}
+
+std::size_t HandStrength::Batch::add(CardSet hole)
+{
+    assert(hole.size() == 2);
+
+    for (std::size_t i {0}; i < m_board.size(); ++i)
+    {
+        m_cards[i].push_back(m_board[i]);
+    }
+    m_cards[5].push_back(static_cast<CardCode>(std::countr_zero(hole.mask)));
+    m_cards[6].push_back(static_cast<CardCode>(63 - std::countl_zero(hole.mask)));
+    return size() - 1;
+}
+
+void HandStrength::Batch::evaluate(Kernel kernel)
+{
+    SevenCardColumns columns {};
+    for (std::size_t i {0}; i < columns.size(); ++i)
+    {
+        columns[i] = m_cards[i].data();
+    }
+
+    m_strengths.resize(size());
+    {
+        Profile::Scope timer {Profile::evaluate};
+        HandStrength::evaluate(columns, size(), m_strengths.data(), kernel);
+    }
+
+    if constexpr (Profile::enabled)
+    {
+        for (auto strength : m_strengths)
+        {
+            Profile::countCategory(category(strength));
+        }
+    }
+}
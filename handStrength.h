@@ -0,0 +1,93 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "deck.h"
+#include "pokerGame.h"
+
+// Table-driven hand evaluator. Any 5, 6 or 7 card set maps to one 16-bit strength: the hand category sits in the
+// top bits and the rank of the hand within its category in the low bits, so comparing strengths orders hands
+// completely. The tables are built from the mask evaluators in pokerGame.cpp on first use.
+namespace HandStrength
+{
+    using Strength = std::uint16_t;
+
+    constexpr int categoryShift {12};
+
+    Strength evaluate(CardSet cards);
+
+    // Seven-card hands laid out card by card: cards[i][n] is the code of the i-th card of hand n
+    using SevenCardColumns = std::array<const CardCode*, 7>;
+
+    enum Kernel
+    {
+        kernel_scalar,
+        kernel_avx2,
+        kernel_avx512,
+
+        max_kernels
+    };
+
+    const char* kernelName(Kernel kernel);
+    bool supported(Kernel kernel);
+
+    // The widest kernel the running CPU supports, detected once
+    Kernel bestKernel();
+
+    // strengths[n] = evaluate(hand n) for every n below count. The vector kernels score 8 (AVX2) or 16 (AVX-512)
+    // hands at once from the same tables, so they give exactly the scalar results. A kernel the CPU lacks falls
+    // back to the next narrower one.
+    void evaluate(const SevenCardColumns& cards, std::size_t count, Strength* strengths, Kernel kernel = bestKernel());
+
+    // Hands on complete boards, collected to be scored together by the batch kernels. The storage is kept between
+    // rounds, so once it has grown to the largest round, collecting and scoring hands allocates nothing.
+    class Batch
+    {
+        private:
+            std::array<std::vector<CardCode>, 7> m_cards {};
+            std::vector<Strength> m_strengths {};
+            std::array<CardCode, 5> m_board {};
+
+        public:
+            void clear();
+            std::size_t size() const { return m_cards.front().size(); }
+
+            // Sets the five-card board that the hands added next are made with
+            void setBoard(CardSet board);
+
+            // Adds the hand made of the board and two hole cards, returning its index
+            std::size_t add(CardSet hole);
+
+            // Scores every hand added since the last clear
+            void evaluate(Kernel kernel = bestKernel());
+
+            Strength strength(std::size_t index) const { return m_strengths[index]; }
+    };
+
+    // The value and suit summary of a board, built once per showdown so that each player only adds their hole cards
+    // to it. Only a suit the board holds at least three of can make a flush, so at most one suit is checked.
+    class Board
+    {
+        private:
+            std::uint16_t m_any {};
+            std::uint16_t m_atLeastTwo {};
+            std::uint16_t m_atLeastThree {};
+            std::uint16_t m_four {};
+            std::uint16_t m_flushCards {};
+            int m_flushSuit {-1};
+            int m_numCards {};
+
+        public:
+            explicit Board(CardSet cards);
+
+            // The same as HandStrength::evaluate(board | hole) for two hole cards
+            Strength evaluate(CardSet hole) const;
+    };
+
+    constexpr Settings::Rankings category(Strength strength)
+    {
+        return static_cast<Settings::Rankings>(strength >> categoryShift);
+    }
+}
@@ -0,0 +1,496 @@
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "equityCalc.h"
+#include "batch.h"
+#include "preflopTable.h"
+#include "equityCache.h"
+#include "range.h"
+#include "rng.h"
+#include "rangeMatrix.h"
+#include "strengthDistribution.h"
+#include "server.h"
+#include "profile.h"
+
+// One line per hand: the hand, then ehs=, ehs2=, runouts= and hist= with the bins' fractions comma separated
+static void writeDistribution(std::ostream& out, CardSet hand, const StrengthDistribution& distribution)
+{
+    hand.forEach([&](Card card) { out << card; });
+    out << " ehs=" << distribution.ehs << " ehs2=" << distribution.ehsSquared << " runouts=" << distribution.runouts
+        << " hist=";
+    for (std::size_t bin {0}; bin < distribution.histogram.size(); ++bin)
+    {
+        out << (bin == 0 ? "" : ",") << distribution.histogram[bin];
+    }
+    out << '\n';
+}
+
+// With --profile, counts hardware events from construction and prints the profile when main() returns, also writing
+// it as JSON to file when one is given
+class ProfileReport
+{
+    public:
+        ProfileReport(bool active, std::string file)
+        : m_active {active}, m_file {std::move(file)}
+        {
+            if (m_active)
+            {
+                Profile::reset();
+                m_hardware.start();
+            }
+        }
+
+        ~ProfileReport()
+        {
+            if (!m_active)
+            {
+                return;
+            }
+
+            auto counters {Profile::totals()};
+            std::optional<Profile::Hardware::Reading> reading {};
+            if (m_hardware.available())
+            {
+                reading = m_hardware.read();
+            }
+
+            Profile::print(std::cerr, counters, reading ? &*reading : nullptr);
+            if (!m_file.empty())
+            {
+                std::ofstream out {m_file};
+                out << Profile::json(counters, reading ? &*reading : nullptr) << '\n';
+                if (!out)
+                {
+                    std::cerr << "Could not write " << m_file << '\n';
+                }
+            }
+        }
+
+        ProfileReport(const ProfileReport&) = delete;
+        ProfileReport& operator=(const ProfileReport&) = delete;
+
+    private:
+        bool m_active {};
+        std::string m_file {};
+        Profile::Hardware m_hardware {};
+};
+
+// The server that SIGINT and SIGTERM stop
+static EquityServer* runningServer {nullptr};
+
+static void stopServer(int)
+{
+    if (runningServer)
+    {
+        runningServer->stop();
+    }
+}
+
+// Reads the whole of text as a number into value, or prints a usage error naming flag and returns false
+template <typename T>
+static bool parseFlagValue(std::string_view flag, std::string_view text, T& value)
+{
+    T parsed {};
+    const char* end {text.data() + text.size()};
+    auto [last, error] {std::from_chars(text.data(), end, parsed)};
+    if (text.empty() || error != std::errc {} || last != end)
+    {
+        std::cerr << "Bad value for " << flag << ": " << text << '\n';
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+// Usage:
+//     equityCalc                          asks for one scenario interactively
+//     equityCalc --batch [file]           runs the scenarios in file (or stdin) as described in batch.h
+//     equityCalc --generate-preflop file  computes the heads-up preflop table and writes it to file
+//     equityCalc --range-matrix file --hero range --villain range [--board cards] [--runouts n]
+//                                         writes every hero combo's equity against every villain combo, see rangeMatrix.h
+//     equityCalc --strength file [--hero range] [--villain range] [--board cards] [--bins n] [--runouts n]
+//                                         writes each hero hand's strength histogram, EHS and EHS^2 against the villain
+//                                         range (or a random hand), one line per hand, see strengthDistribution.h
+//     equityCalc --outs                   asks for a flop or turn scenario and prints the equity after each next card
+//     equityCalc --serve address          answers batch lines from clients of a Unix socket (a path) or a TCP port on
+//                                         127.0.0.1 until interrupted, see server.h
+//     --preflop file                      answers heads-up preflop spots from a generated table
+//     --cache file                        keeps results in file between runs, see equityCache.h
+//     --cache-size n                      sets the number of results the cache holds
+//     --precision p                       samples until the 95% interval on equity is within +/- p
+//     --trials n                          sets the most trials the interactive scenario samples
+//     --progress ms                       prints the interactive scenario's equity so far every ms milliseconds
+//     --deadline ms                       stops sampling the interactive scenario after ms milliseconds
+//     --sampler name                      samples with plain, stratified, antithetic or quasi draws, see simulation.h
+//     --control-variate                   uses the --preflop table as a control variate when sampling
+//     --pot p --call c                    also prints the decision to call c chips into a pot of p (including the bet)
+//     --threads n                         sets the number of worker threads
+//     --seed s                            seeds every generator, so the same seed and thread count repeat a run
+//     --profile [file]                    prints where the run's time went when it ends, and writes it to file as
+//                                         JSON; stage counters need a build with -DPROFILE_STAGES, see profile.h
+int main(int argc, char* argv[])
+{
+    std::vector<std::string_view> args(argv + 1, argv + argc);
+
+    unsigned threads {std::max(1u, std::thread::hardware_concurrency())};
+    std::uint64_t seed {entropySeed()};
+    bool batch {false};
+    bool outs {false};
+    std::string batchFile {};
+    std::string serveAddress {};
+    std::string generateFile {};
+    std::string matrixFile {};
+    std::string strengthFile {};
+    int bins {defaultStrengthBins};
+    std::string heroRange {};
+    std::string villainRange {};
+    std::string boardCards {};
+    std::int64_t maxRunouts {RangeMatrix::defaultMaxRunouts};
+    std::string preflopFile {};
+    double precision {0};
+    int trials {0};
+    std::chrono::milliseconds progressInterval {};
+    std::chrono::milliseconds deadline {};
+    PotOdds odds {};
+    Sampling sampling {};
+    bool controlVariate {false};
+    std::string cacheFile {};
+    std::size_t cacheSize {EquityCache::defaultCapacity};
+    bool profile {false};
+    std::string profileFile {};
+
+    for (std::size_t i {0}; i < args.size(); ++i)
+    {
+        if (args[i] == "--threads" && i + 1 < args.size())
+        {
+            int count {};
+            if (!parseFlagValue(args[i], args[i + 1], count))
+            {
+                return 1;
+            }
+            threads = static_cast<unsigned>(std::max(1, count));
+            ++i;
+        }
+        else if (args[i] == "--seed" && i + 1 < args.size())
+        {
+            if (!parseFlagValue(args[i], args[i + 1], seed))
+            {
+                return 1;
+            }
+            ++i;
+        }
+        else if (args[i] == "--batch")
+        {
+            batch = true;
+            if (i + 1 < args.size() && !args[i + 1].starts_with("--"))
+            {
+                batchFile = args[++i];
+            }
+        }
+        else if (args[i] == "--profile")
+        {
+            profile = true;
+            if (i + 1 < args.size() && !args[i + 1].starts_with("--"))
+            {
+                profileFile = args[++i];
+            }
+        }
+        else if (args[i] == "--serve" && i + 1 < args.size())
+        {
+            serveAddress = args[++i];
+        }
+        else if (args[i] == "--generate-preflop" && i + 1 < args.size())
+        {
+            generateFile = args[++i];
+        }
+        else if (args[i] == "--cache" && i + 1 < args.size())
+        {
+            cacheFile = args[++i];
+        }
+        else if (args[i] == "--cache-size" && i + 1 < args.size())
+        {
+            if (!parseFlagValue(args[i], args[i + 1], cacheSize))
+            {
+                return 1;
+            }
+            ++i;
+        }
+        else if (args[i] == "--outs")
+        {
+            outs = true;
+        }
+        else if (args[i] == "--range-matrix" && i + 1 < args.size())
+        {
+            matrixFile = args[++i];
+        }
+        else if (args[i] == "--strength" && i + 1 < args.size())
+        {
+            strengthFile = args[++i];
+        }
+        else if (args[i] == "--bins" && i + 1 < args.size())
+        {
+            if (!parseFlagValue(args[i], args[i + 1], bins))
+            {
+                return 1;
+            }
+            bins = std::max(1, bins);
+            ++i;
+        }
+        else if (args[i] == "--hero" && i + 1 < args.size())
+        {
+            heroRange = args[++i];
+        }
+        else if (args[i] == "--villain" && i + 1 < args.size())
+        {
+            villainRange = args[++i];
+        }
+        else if (args[i] == "--board" && i + 1 < args.size())
+        {
+            boardCards = args[++i];
+        }
+        else if (args[i] == "--runouts" && i + 1 < args.size())
+        {
+            if (!parseFlagValue(args[i], args[i + 1], maxRunouts))
+            {
+                return 1;
+            }
+            maxRunouts = std::max(std::int64_t {1}, maxRunouts);
+            ++i;
+        }
+        else if (args[i] == "--pot" && i + 1 < args.size())
+        {
+            if (!parseFlagValue(args[i], args[i + 1], odds.pot))
+            {
+                return 1;
+            }
+            ++i;
+        }
+        else if (args[i] == "--call" && i + 1 < args.size())
+        {
+            if (!parseFlagValue(args[i], args[i + 1], odds.toCall))
+            {
+                return 1;
+            }
+            ++i;
+        }
+        else if (args[i] == "--sampler" && i + 1 < args.size())
+        {
+            auto method {Sampling::parse(args[++i])};
+            if (!method)
+            {
+                std::cerr << "Unknown sampler: " << args[i] << '\n';
+                return 1;
+            }
+            sampling.method = *method;
+        }
+        else if (args[i] == "--control-variate")
+        {
+            controlVariate = true;
+        }
+        else if (args[i] == "--precision" && i + 1 < args.size())
+        {
+            if (!parseFlagValue(args[i], args[i + 1], precision))
+            {
+                return 1;
+            }
+            ++i;
+        }
+        else if (args[i] == "--trials" && i + 1 < args.size())
+        {
+            if (!parseFlagValue(args[i], args[i + 1], trials))
+            {
+                return 1;
+            }
+            trials = std::max(1, trials);
+            ++i;
+        }
+        else if (args[i] == "--progress" && i + 1 < args.size())
+        {
+            std::int64_t count {};
+            if (!parseFlagValue(args[i], args[i + 1], count))
+            {
+                return 1;
+            }
+            progressInterval = std::chrono::milliseconds {count};
+            ++i;
+        }
+        else if (args[i] == "--deadline" && i + 1 < args.size())
+        {
+            std::int64_t count {};
+            if (!parseFlagValue(args[i], args[i + 1], count))
+            {
+                return 1;
+            }
+            deadline = std::chrono::milliseconds {count};
+            ++i;
+        }
+        else if (args[i] == "--preflop" && i + 1 < args.size())
+        {
+            preflopFile = args[++i];
+        }
+        else
+        {
+            std::cerr << "Unknown argument: " << args[i] << '\n';
+            return 1;
+        }
+    }
+
+    ProfileReport profileReport {profile, profileFile};
+
+    if (!generateFile.empty())
+    {
+        if (!PreflopTable::generate(generateFile, threads))
+        {
+            std::cerr << "Could not write " << generateFile << '\n';
+            return 1;
+        }
+        return 0;
+    }
+
+    if (!matrixFile.empty())
+    {
+        auto hero {Range::parse(heroRange)};
+        auto villain {Range::parse(villainRange)};
+        auto board {CardSet::fromString(boardCards)};
+        if (!hero || !villain || !board || board->size() > 5 || (board->size() > 0 && board->size() < 3))
+        {
+            std::cerr << "--range-matrix needs --hero and --villain ranges and a board of 0, 3, 4 or 5 cards\n";
+            return 1;
+        }
+
+        Xoshiro256 rng {seed};
+        auto matrix {RangeMatrix::compute(*hero, *villain, *board, threads, rng, maxRunouts)};
+        if (!matrix.write(matrixFile))
+        {
+            std::cerr << "Could not write " << matrixFile << '\n';
+            return 1;
+        }
+        return 0;
+    }
+
+    if (!strengthFile.empty())
+    {
+        auto hero {heroRange.empty() ? std::optional<Range> {Range {}} : Range::parse(heroRange)};
+        auto villain {villainRange.empty() ? std::optional<Range> {Range {}} : Range::parse(villainRange)};
+        auto board {CardSet::fromString(boardCards)};
+        if (!hero || !villain || !board || board->size() > 5 || (board->size() > 0 && board->size() < 3))
+        {
+            std::cerr << "--strength needs valid --hero and --villain ranges if given and a board of 0, 3, 4 or 5 cards\n";
+            return 1;
+        }
+
+        std::vector<CardSet> hands {heroRange.empty() ? allHands(*board) : std::vector<CardSet> {}};
+        for (const auto& combo : hero->combos())
+        {
+            if (!combo.cards.intersects(*board))
+            {
+                hands.push_back(combo.cards);
+            }
+        }
+
+        std::ofstream out {strengthFile};
+        Xoshiro256 rng {seed};
+        auto distributions {strengthDistributions(hands, *board, villainRange.empty() ? nullptr : &*villain, threads,
+            rng, bins, maxRunouts)};
+        for (std::size_t i {0}; i < hands.size(); ++i)
+        {
+            writeDistribution(out, hands[i], distributions[i]);
+        }
+        if (!out)
+        {
+            std::cerr << "Could not write " << strengthFile << '\n';
+            return 1;
+        }
+        return 0;
+    }
+
+    PreflopTable preflop {};
+    if (!preflopFile.empty() && !preflop.open(preflopFile))
+    {
+        std::cerr << "Could not load the preflop table " << preflopFile << '\n';
+        return 1;
+    }
+    const PreflopTable* preflopTable {preflopFile.empty() ? nullptr : &preflop};
+    if (controlVariate && !preflopTable)
+    {
+        std::cerr << "--control-variate needs a --preflop table\n";
+        return 1;
+    }
+    sampling.controlTable = controlVariate ? preflopTable : nullptr;
+
+    EquityCache cache {cacheSize};
+    EquityCache* equityCache {cacheFile.empty() ? nullptr : &cache};
+    if (equityCache && !cache.load(cacheFile) && std::ifstream {cacheFile})
+    {
+        std::cerr << "Ignoring " << cacheFile << ", which is not an equity cache\n";
+    }
+
+    if (!serveAddress.empty())
+    {
+        // The server always keeps results in memory, and only in the file when --cache gives one
+        EquityServer server {threads, seed, preflopTable, cache};
+        if (auto error {server.listen(serveAddress)}; !error.empty())
+        {
+            std::cerr << error << '\n';
+            return 1;
+        }
+
+        runningServer = &server;
+        std::signal(SIGINT, stopServer);
+        std::signal(SIGTERM, stopServer);
+        std::cerr << "Listening on " << serveAddress << '\n';
+        server.run();
+        runningServer = nullptr;
+    }
+    else if (batch)
+    {
+        std::ios::sync_with_stdio(false);
+        if (batchFile.empty() || batchFile == "-")
+        {
+            runBatch(std::cin, std::cout, threads, seed, preflopTable, equityCache);
+        }
+        else
+        {
+            std::ifstream in {batchFile};
+            if (!in)
+            {
+                std::cerr << "Could not open " << batchFile << '\n';
+                return 1;
+            }
+            runBatch(in, std::cout, threads, seed, preflopTable, equityCache);
+        }
+    }
+    else if (outs)
+    {
+        runOuts(10000, threads, seed);
+    }
+    else if (precision > 0)
+    {
+        runTests((trials > 0) ? trials : 10000000, threads, seed, preflopTable, precision, equityCache, odds, sampling,
+            progressInterval, deadline);
+    }
+    else
+    {
+        runTests((trials > 0) ? trials : 1000, threads, seed, preflopTable, 0, equityCache, odds, sampling,
+            progressInterval, deadline);
+    }
+
+    if (equityCache && !cache.save(cacheFile))
+    {
+        std::cerr << "Could not write " << cacheFile << '\n';
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,65 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+#include "deck.h"
+#include "handStrength.h"
+#include "pokerGame.h"
+#include "rng.h"
+#include "simulation.h"
+#include "outs.h"
+
+OutsReport outsReport(const Scenario& scenario, std::int64_t tries, unsigned threads, Xoshiro256& rng)
+{
+    assert(scenario.numHands > 0 && scenario.numCommunal >= 3 && scenario.numCommunal < 5 &&
+        "outsReport needs the hero's hand and a flop or turn");
+
+    OutsReport report {};
+
+    CardSet usedCards {scenario.usedCards()};
+    std::vector<Card> liveCards {};
+    for (CardCode code {0}; code < 52; ++code)
+    {
+        if (!(usedCards.mask & CardSet::bit(code)))
+        {
+            liveCards.push_back(Card::fromCode(code));
+        }
+    }
+
+    auto budget {tries * static_cast<std::int64_t>(liveCards.size())};
+    std::vector<EquityResult> byCard {};
+    if (scenario.ranges.empty() && exactShowdowns(scenario) <= static_cast<double>(budget))
+    {
+        report.current = enumerateByNextCard(scenario, threads, byCard);
+    }
+    else
+    {
+        report.current = simulateByNextCard(scenario, budget, threads, rng, byCard);
+    }
+
+    for (auto card : liveCards)
+    {
+        report.nextCards.push_back({card, byCard[card.code()]});
+    }
+
+    CardSet heroCards {scenario.communalCards | scenario.players.front().hand};
+    for (auto& next : report.nextCards)
+    {
+        auto cards {heroCards};
+        cards.add(next.card);
+        next.madeHand = HandStrength::category(HandStrength::evaluate(cards));
+
+        // Sampled equities must clear their combined margin so that noise is not counted as an out
+        if (next.result.equity() > report.current.equity() + next.result.margin() + report.current.margin())
+        {
+            report.outs[next.madeHand].push_back(next.card);
+        }
+    }
+
+    std::stable_sort(report.nextCards.begin(), report.nextCards.end(), [](const NextCard& a, const NextCard& b)
+    {
+        return a.result.equity() > b.result.equity();
+    });
+
+    return report;
+}
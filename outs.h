@@ -0,0 +1,36 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "deck.h"
+#include "pokerGame.h"
+#include "rng.h"
+#include "simulation.h"
+
+struct NextCard
+{
+    Card card {};
+    EquityResult result {};
+
+    // The category of the hero's best hand once this card is dealt
+    Settings::Rankings madeHand {};
+};
+
+struct OutsReport
+{
+    EquityResult current {};
+
+    // Every card that can come next, best for the hero first
+    std::vector<NextCard> nextCards {};
+
+    // The cards that raise the hero's equity above current (beyond the 95% margins when sampled), grouped by the
+    // category of hand they make
+    std::array<std::vector<Card>, Settings::max_rankings> outs {};
+};
+
+// The hero's equity after each possible turn or river card. Scenarios without ranges whose exact enumeration
+// takes no more showdowns than tries per card are answered by one enumeration that credits every runout to the
+// cards it contains; others by one stratified sampling pass from rng of tries trials for each card, each trial
+// credited to its next card. Either way current is the sum over the cards. Needs a fixed hero hand and a flop or turn.
+OutsReport outsReport(const Scenario& scenario, std::int64_t tries, unsigned threads, Xoshiro256& rng);
@@ -1,6 +1,8 @@
 #include <iostream>
 #include <vector>
 #include <ranges>
+#include <bit>
+#include <cstdint>
 #include "pokerGame.h"
 #include "deck.h"
 
@@ -13,7 +15,7 @@ std::ostream& Settings::operator<<(std::ostream& out, const Rankings ranking)
     return out;
 }
 
-bool Player::operator<(const Player otherPlayer) const
+bool Player::operator<(const Player& otherPlayer) const
 {
     if (handType != otherPlayer.handType)
     {
@@ -34,7 +36,7 @@ bool Player::operator<(const Player otherPlayer) const
     return false;
 }
 
-bool Player::operator==(const Player otherPlayer) const
+bool Player::operator==(const Player& otherPlayer) const
 {
     if (handType != otherPlayer.handType)
     {
@@ -54,7 +56,8 @@ bool Player::operator==(const Player otherPlayer) const
 
 void Player::print() const
 {
-    std::cout << hand.data()[0] << ' ' << hand.data()[1] << '\n';
+    hand.forEach([](Card card) { std::cout << card << ' '; });
+    std::cout << '\n';
     std::cout << handType << '\n';
     
     for (const auto& i : bestHand)
@@ -66,154 +69,122 @@ void Player::print() const
 }
 
 
-std::vector<Card> flush(std::vector<Card> cards)
+ValueMasks::ValueMasks(CardSet cards)
 {
-    std::vector<Card> bestHand(5);
+    auto c {cards.suitMask(Card::suit_clubs)};
+    auto d {cards.suitMask(Card::suit_diamonds)};
+    auto h {cards.suitMask(Card::suit_hearts)};
+    auto s {cards.suitMask(Card::suit_spades)};
+
+    any = c | d | h | s;
+    atLeastTwo = (c & d) | (c & h) | (c & s) | (d & h) | (d & s) | (h & s);
+    atLeastThree = (c & d & h) | (c & d & s) | (c & h & s) | (d & h & s);
+    four = c & d & h & s;
+}
 
-    Card::groupBySuitSort = true;
-    std::vector<Card> cardsCopy = cards;
-    std::sort(cardsCopy.begin(),cardsCopy.end());
-    
-    Card::Suits prevSuit {Card::max_suits};
-    std::size_t curPos {};
-    for (const auto& i : std::views::reverse(cardsCopy))
-    {
-        if (i.suit != prevSuit)
-        {
-            curPos = 0;
-            prevSuit = i.suit;
-        }
+int straightHigh(std::uint16_t values)
+{
+    // Shift the values up by one so bit 0 can hold the ace playing low
+    unsigned extended {static_cast<unsigned>(values << 1) | ((values >> (Card::max_ranks - 1)) & 1u)};
+    unsigned runs {extended & (extended >> 1) & (extended >> 2) & (extended >> 3) & (extended >> 4)};
 
-        bestHand[curPos++] = i;
-        if (curPos>=5)
-        {
-            return bestHand;
-        }
+    if (!runs)
+    {
+        return -1;
     }
-    
-    return {};
 
+    return static_cast<int>(std::bit_width(runs)) + 2;
 }
 
-
-std::vector<Card> straight(std::vector<Card> cards)
+static int highestValue(std::uint16_t values)
 {
-    std::array<Card, Card::max_ranks+1> rankCounter {};
-    std::vector<Card> bestHand {};
-    bestHand.reserve(5);
+    return std::bit_width(values) - 1;
+}
 
-    for (auto& i : rankCounter)
-    {
-        i = Card {Card::max_ranks,Card::max_suits};
-    }
+static std::uint16_t valueBit(int value)
+{
+    return static_cast<std::uint16_t>(1 << value);
+}
 
-    for (const auto& i : cards)
-    {
-        rankCounter.data()[i.rank] = i;
-        if (i.rank == 0)
-        {
-            rankCounter.data()[Card::max_ranks] = i;
-        }
-    }
+static Card cardAt(int value, int suit)
+{
+    return Card::fromCode(static_cast<CardCode>(suit * Card::max_ranks + value));
+}
 
-    for (const auto& i : std::views::reverse(rankCounter))
+// Appends cards whose value is in values, highest value (then highest suit) first, until bestHand holds size cards
+static void appendCards(BestHand& bestHand, CardSet cards, std::uint16_t values, std::size_t size)
+{
+    for (int value {highestValue(values)}; value >= 0 && bestHand.size() < size; --value)
     {
-        if (i.rank != Card::max_ranks && i.suit != Card::max_suits)
+        if (!(values & valueBit(value)))
         {
-            bestHand.push_back(i);
-        }
-        else
-        {
-            bestHand.clear();
+            continue;
         }
 
-        if (std::ssize(bestHand) == 5)
+        for (int suit {Card::max_suits - 1}; suit >= 0 && bestHand.size() < size; --suit)
         {
-            return bestHand;
+            if (cards.suitMask(suit) & valueBit(value))
+            {
+                bestHand.push_back(cardAt(value, suit));
+            }
         }
-
     }
-
-    return {};
 }
 
 
-std::vector<Card> straightFlush(std::vector<Card> cards)
+BestHand flush(CardSet cards)
 {
-    std::array suitCounter {0,0,0,0};
-    Card::Suits maxSuit  {Card::max_suits};
-    int maxSuitCount {0};
+    BestHand bestHand {};
 
-    for (const auto& i : cards)
+    for (int suit {Card::max_suits - 1}; suit >= 0; --suit)
     {
-        if ((++suitCounter.data()[i.suit]) > maxSuitCount)
-        {
-            maxSuitCount = suitCounter.data()[i.suit];
-            maxSuit = i.suit;
+        auto suited {cards.suitMask(suit)};
+        if (std::popcount(suited) >= 5)
+        {
+            for (int value {highestValue(suited)}; std::ssize(bestHand) < 5; --value)
+            {
+                if (suited & valueBit(value))
+                {
+                    bestHand.push_back(cardAt(value, suit));
+                }
+            }
+            return bestHand;
         }
     }
 
-    if (maxSuitCount < 5)
+    return {};
+
+}
+
+
+BestHand straight(CardSet cards)
+{
+    int high {straightHigh(ValueMasks {cards}.any)};
+    if (high < 0)
     {
         return {};
     }
 
-    std::vector<Card> candidates {};
-    candidates.reserve(std::size(cards));
+    BestHand bestHand {};
 
-    for (const auto& i : cards)
+    for (int value {high}; value > high - 5; --value)
     {
-        if (i.suit == maxSuit)
-        {
-            candidates.push_back(i);
-        }
+        // A value of -1 is the ace playing low in a five-high straight
+        appendCards(bestHand, cards, valueBit((value < 0) ? Card::max_ranks - 1 : value), bestHand.size() + 1);
     }
 
-    return straight(candidates);
+    return bestHand;
 }
 
 
-std::vector<Card> fourOfKind(std::vector<Card> cards)
+BestHand straightFlush(CardSet cards)
 {
-    std::vector<Card> bestHand {};
-    bestHand.reserve(5);
-    std::vector<Card> cardsCopy = cards;
-
-    Card::groupBySuitSort = false;
-    std::sort(cardsCopy.begin(),cardsCopy.end());
-
-    int rankCount {0};
-    for (const auto& i : std::views::reverse(cardsCopy))
+    for (int suit {0}; suit < Card::max_suits; ++suit)
     {
-        if (!bestHand.empty() && bestHand.back().rank == i.rank)
+        if (std::popcount(cards.suitMask(suit)) >= 5)
         {
-            ++rankCount;
-            bestHand.push_back(i);
-        }
-        else
-        {
-            bestHand.clear();
-            bestHand.push_back(i);
-            rankCount = 1;
-        }
-
-        if (rankCount == 4)
-        {
-            break;
-        }
-    }
-
-    if (rankCount < 4)
-    {
-        return {};
-    }
-
-    for (const auto& i : std::views::reverse(cardsCopy))
-    {
-        if (!(i.rank == bestHand.back().rank))
-        {
-            bestHand.push_back(i);
-            return bestHand;
+            auto suitCards {std::uint64_t {CardSet::suitBits} << (suit * Card::max_ranks)};
+            return straight(cards & CardSet {suitCards});
         }
     }
 
@@ -221,287 +192,131 @@ std::vector<Card> fourOfKind(std::vector<Card> cards)
 }
 
 
-std::vector<Card> threeOfKind(std::vector<Card> cards)
+BestHand fourOfKind(CardSet cards)
 {
-    std::vector<Card> bestHand {};
-    bestHand.reserve(5);
-    std::vector<Card> cardsCopy = cards;
-
-    Card::groupBySuitSort = false;
-    std::sort(cardsCopy.begin(),cardsCopy.end());
-
-    int rankCount {0};
-    for (const auto& i : std::views::reverse(cardsCopy))
-    {
-        if (!bestHand.empty() && bestHand.back().rank == i.rank)
-        {
-            ++rankCount;
-            bestHand.push_back(i);
-        }
-        else
-        {
-            bestHand.clear();
-            bestHand.push_back(i);
-            rankCount = 1;
-        }
-
-        if (rankCount == 3)
-        {
-            break;
-        }
-    }
-
-    if (rankCount < 3)
+    ValueMasks values {cards};
+    if (!values.four)
     {
         return {};
     }
 
-    int cardsAdded {0};
-    for (const auto& i : std::views::reverse(cardsCopy))
-    {
-        if (!(i.rank == bestHand.data()[0].rank))
-        {
-            bestHand.push_back(i);
-            ++cardsAdded;
-        }
-        if (cardsAdded == 2)
-        {
-            return bestHand;
-        }
-    }
+    BestHand bestHand {};
 
-    return {};
+    auto quads {valueBit(highestValue(values.four))};
+    appendCards(bestHand, cards, quads, 4);
+    appendCards(bestHand, cards, values.any & ~quads, 5);
+
+    return bestHand;
 }
 
 
-std::vector<Card> pair(std::vector<Card> cards)
+BestHand threeOfKind(CardSet cards)
 {
-    std::vector<Card> bestHand {};
-    bestHand.reserve(5);
-    std::vector<Card> cardsCopy = cards;
-
-    Card::groupBySuitSort = false;
-    std::sort(cardsCopy.begin(),cardsCopy.end());
-
-    int rankCount {0};
-    for (const auto& i : std::views::reverse(cardsCopy))
-    {
-        if (!bestHand.empty() && bestHand.back().rank == i.rank)
-        {
-            ++rankCount;
-            bestHand.push_back(i);
-        }
-        else
-        {
-            bestHand.clear();
-            bestHand.push_back(i);
-            rankCount = 1;
-        }
-
-        if (rankCount == 2)
-        {
-            break;
-        }
-    }
-
-    if (rankCount < 2)
+    ValueMasks values {cards};
+    if (!values.atLeastThree)
     {
         return {};
     }
 
-    int cardsAdded {0};
-    for (const auto& i : std::views::reverse(cardsCopy))
+    BestHand bestHand {};
+
+    auto trips {valueBit(highestValue(values.atLeastThree))};
+    appendCards(bestHand, cards, trips, 3);
+    appendCards(bestHand, cards, values.any & ~trips, 5);
+
+    if (std::ssize(bestHand) < 5)
     {
-        if (!(i.rank == bestHand.data()[0].rank))
-        {
-            bestHand.push_back(i);
-            ++cardsAdded;
-        }
-        if (cardsAdded == 3)
-        {
-            return bestHand;
-        }
+        return {};
     }
 
-    return {};
+    return bestHand;
 }
 
 
-std::vector<Card> fullHouse(std::vector<Card> cards)
+BestHand pair(CardSet cards)
 {
-    std::vector<Card> bestHand {};
-    bestHand.reserve(5);
-    std::vector<Card> cardsCopy = cards;
-
-    Card::groupBySuitSort = false;
-    std::sort(cardsCopy.begin(),cardsCopy.end());
-
-    int rankCount {0};
-    for (const auto& i : std::views::reverse(cardsCopy))
-    {
-        if (!bestHand.empty() && bestHand.back().rank == i.rank)
-        {
-            ++rankCount;
-            bestHand.push_back(i);
-        }
-        else
-        {
-            bestHand.clear();
-            bestHand.push_back(i);
-            rankCount = 1;
-        }
-
-        if (rankCount == 3)
-        {
-            break;
-        }
-    }
-
-    if (rankCount < 3)
+    ValueMasks values {cards};
+    if (!values.atLeastTwo)
     {
         return {};
     }
 
-    Card::Ranks foundThree {bestHand.data()[0].rank};
-    std::vector<Card> findTwo {};
-    rankCount = 0;
+    BestHand bestHand {};
 
-    for (const auto& i : std::views::reverse(cardsCopy))
-    {
-        if (!findTwo.empty() && findTwo.back().rank == i.rank && !(foundThree == i.rank))
-        {
-            ++rankCount;
-            findTwo.push_back(i);
-        }
-        else if (!(foundThree == i.rank))
-        {
-            findTwo.clear();
-            findTwo.push_back(i);
-            rankCount = 1;
-        }
-        else
-        {
-            rankCount = 0;
-        }
+    auto pairValue {valueBit(highestValue(values.atLeastTwo))};
+    appendCards(bestHand, cards, pairValue, 2);
+    appendCards(bestHand, cards, values.any & ~pairValue, 5);
 
-        if (rankCount == 2)
-        {
-            break;
-        }
-    }
-
-    if (rankCount < 2)
+    if (std::ssize(bestHand) < 5)
     {
         return {};
     }
 
-    bestHand.push_back(findTwo.data()[0]);
-    bestHand.push_back(findTwo.data()[1]);
-
     return bestHand;
-
 }
 
 
-std::vector<Card> twoPair(std::vector<Card> cards)
+BestHand fullHouse(CardSet cards)
 {
-    std::vector<Card> bestHand {};
-    bestHand.reserve(5);
-    std::vector<Card> cardsCopy = cards;
-
-    Card::groupBySuitSort = false;
-    std::sort(cardsCopy.begin(),cardsCopy.end());
-
-    int rankCount {0};
-    for (const auto& i : std::views::reverse(cardsCopy))
+    ValueMasks values {cards};
+    if (!values.atLeastThree)
     {
-        if (!bestHand.empty() && bestHand.back().rank == i.rank)
-        {
-            ++rankCount;
-            bestHand.push_back(i);
-        }
-        else
-        {
-            bestHand.clear();
-            bestHand.push_back(i);
-            rankCount = 1;
-        }
-
-        if (rankCount == 2)
-        {
-            break;
-        }
+        return {};
     }
 
-    if (rankCount < 2)
+    auto trips {valueBit(highestValue(values.atLeastThree))};
+    auto pairs {static_cast<std::uint16_t>(values.atLeastTwo & ~trips)};
+    if (!pairs)
     {
         return {};
     }
 
-    Card::Ranks foundFirstTwo {bestHand.data()[0].rank};
-    std::vector<Card> findTwo {};
-    rankCount = 0;
+    BestHand bestHand {};
 
-    for (const auto& i : std::views::reverse(cardsCopy))
-    {
-        if (!findTwo.empty() && findTwo.back().rank == i.rank && !(foundFirstTwo == i.rank))
-        {
-            ++rankCount;
-            findTwo.push_back(i);
-        }
-        else if (!(foundFirstTwo == i.rank))
-        {
-            findTwo.clear();
-            findTwo.push_back(i);
-            rankCount = 1;
-        }
-        else
-        {
-            rankCount = 0;
-        }
+    appendCards(bestHand, cards, trips, 3);
+    appendCards(bestHand, cards, valueBit(highestValue(pairs)), 5);
 
-        if (rankCount == 2)
-        {
-            break;
-        }
+    return bestHand;
+
+}
+
+
+BestHand twoPair(CardSet cards)
+{
+    ValueMasks values {cards};
+    if (!values.atLeastTwo)
+    {
+        return {};
     }
 
-    if (rankCount < 2)
+    auto firstPair {valueBit(highestValue(values.atLeastTwo))};
+    auto otherPairs {static_cast<std::uint16_t>(values.atLeastTwo & ~firstPair)};
+    if (!otherPairs)
     {
         return {};
     }
 
-    bestHand.push_back(findTwo.data()[0]);
-    bestHand.push_back(findTwo.data()[1]);
+    BestHand bestHand {};
 
-    Card::Ranks foundSecondTwo {bestHand.back().rank};
+    auto secondPair {valueBit(highestValue(otherPairs))};
+    appendCards(bestHand, cards, firstPair, 2);
+    appendCards(bestHand, cards, secondPair, 4);
+    appendCards(bestHand, cards, values.any & ~(firstPair | secondPair), 5);
 
-    for (const auto& i : std::views::reverse(cardsCopy))
+    if (std::ssize(bestHand) < 5)
     {
-        if (!(i.rank == foundFirstTwo || i.rank == foundSecondTwo))
-        {
-            bestHand.push_back(i);
-            return bestHand;
-        }
+        return {};
     }
 
-    return {};
+    return bestHand;
 }
 
 
-std::vector<Card> highCard(std::vector<Card> cards)
+BestHand highCard(CardSet cards)
 {
-    std::vector<Card> bestHand {};
-    bestHand.reserve(5);
-    std::vector<Card> cardsCopy = cards;
+    BestHand bestHand {};
 
-    Card::groupBySuitSort = false;
-    std::sort(cardsCopy.begin(),cardsCopy.end());
-
-    for (const auto& i : std::views::reverse(cardsCopy))
-    {
-        bestHand.push_back(i);
-    }
+    appendCards(bestHand, cards, ValueMasks {cards}.any, 5);
 
     return bestHand;
-}
\ No newline at end of file
+}
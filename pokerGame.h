@@ -1,6 +1,10 @@
 #pragma once
 
 #include <iostream>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 #include "deck.h"
 
@@ -10,6 +14,9 @@ namespace Settings
     [[maybe_unused]] constexpr int bigBlind {2};
     [[maybe_unused]] constexpr int buyIn {200};
 
+    // Each player takes two cards and the board five
+    [[maybe_unused]] constexpr int maxPlayers {23};
+
     enum Rankings
     {
         high_card,
@@ -40,12 +47,35 @@ namespace Settings
     std::ostream& operator<<(std::ostream& out, const Rankings ranking);
 }
 
+// Up to five cards held in place, so evaluating a hand never touches the heap
+class BestHand
+{
+    private:
+        std::array<Card, 5> m_cards {};
+        std::size_t m_size {0};
+
+    public:
+        static constexpr std::size_t capacity {5};
+
+        void push_back(Card card)
+        {
+            assert(m_size < capacity && "BestHand holds five cards");
+            m_cards[m_size++] = card;
+        }
+
+        std::size_t size() const { return m_size; }
+        bool empty() const { return m_size == 0; }
+        const Card& operator[](std::size_t i) const { return m_cards[i]; }
+        const Card* begin() const { return m_cards.data(); }
+        const Card* end() const { return m_cards.data() + m_size; }
+};
+
 struct Player
 {
-    std::array<Card, 2> hand {};
+    CardSet hand {};
     int chips {Settings::buyIn};
     Settings::Rankings handType {};
-    std::vector<Card> bestHand {};
+    BestHand bestHand {};
     bool isPlayer {false};
 
     Player(Card card1, Card card2)
@@ -54,17 +84,38 @@ struct Player
     Player()
     {}
 
-    bool operator<(const Player otherPlayer) const;
-    bool operator==(const Player otherPlayer) const;
+    bool operator<(const Player& otherPlayer) const;
+    bool operator==(const Player& otherPlayer) const;
     void print() const;
 };
 
-std::vector<Card> flush(std::vector<Card> cards);
-std::vector<Card> straight(std::vector<Card> cards);
-std::vector<Card> straightFlush(std::vector<Card> cards);
-std::vector<Card> fourOfKind(std::vector<Card> cards);
-std::vector<Card> threeOfKind(std::vector<Card> cards);
-std::vector<Card> pair(std::vector<Card> cards);
-std::vector<Card> fullHouse(std::vector<Card> cards);
-std::vector<Card> twoPair(std::vector<Card> cards);
-std::vector<Card> highCard(std::vector<Card> cards);
\ No newline at end of file
+// Values (bit n is value n, ace high) held at least once, twice, three times and four times,
+// computed from CardSet::suitMask() without sorting
+struct ValueMasks
+{
+    std::uint16_t any {};
+    std::uint16_t atLeastTwo {};
+    std::uint16_t atLeastThree {};
+    std::uint16_t four {};
+
+    ValueMasks()
+    {}
+
+    explicit ValueMasks(CardSet cards);
+};
+
+// Value of the top card of the highest straight in values, 3 for a five-high straight, or -1 if there is none
+int straightHigh(std::uint16_t values);
+
+// The evaluators return the best five cards of that kind, highest deciding card first, or an empty hand when
+// cards do not hold one. They only read their argument and share no mutable state, so any number of threads can
+// call them at once.
+BestHand flush(CardSet cards);
+BestHand straight(CardSet cards);
+BestHand straightFlush(CardSet cards);
+BestHand fourOfKind(CardSet cards);
+BestHand threeOfKind(CardSet cards);
+BestHand pair(CardSet cards);
+BestHand fullHouse(CardSet cards);
+BestHand twoPair(CardSet cards);
+BestHand highCard(CardSet cards);
\ No newline at end of file
@@ -0,0 +1,258 @@
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "deck.h"
+#include "simulation.h"
+#include "threadPool.h"
+#include "preflopTable.h"
+
+static constexpr std::size_t numCells {PreflopTable::numClasses * PreflopTable::numClasses + PreflopTable::numClasses};
+
+int PreflopTable::handClass(CardSet hand)
+{
+    auto values {hand.rankMask()};
+    int high {std::bit_width(values) - 1};
+    int low {std::countr_zero(values)};
+
+    if (high == low)
+    {
+        return high * (Card::max_ranks + 1);
+    }
+
+    bool suited {false};
+    for (int suit {0}; suit < Card::max_suits; ++suit)
+    {
+        suited = suited || hand.suitMask(suit) == values;
+    }
+
+    return suited ? high * Card::max_ranks + low : low * Card::max_ranks + high;
+}
+
+static std::vector<CardSet> classCombos(int handClass)
+{
+    std::vector<CardSet> combos {};
+    for (CardCode first {0}; first < 52; ++first)
+    {
+        for (CardCode second {static_cast<CardCode>(first + 1)}; second < 52; ++second)
+        {
+            CardSet hand {CardSet::bit(first) | CardSet::bit(second)};
+            if (PreflopTable::handClass(hand) == handClass)
+            {
+                combos.push_back(hand);
+            }
+        }
+    }
+    return combos;
+}
+
+static CardSet permuteSuits(CardSet cards, const std::array<int, Card::max_suits>& permutation)
+{
+    std::uint64_t mask {0};
+    for (int suit {0}; suit < Card::max_suits; ++suit)
+    {
+        mask |= std::uint64_t {cards.suitMask(suit)} << (permutation[static_cast<std::size_t>(suit)] * Card::max_ranks);
+    }
+    return CardSet {mask};
+}
+
+// Sums the exact results of every combo of heroClass against every non-overlapping combo of villainClass.
+// Matchups that are the same up to a permutation of suits are enumerated once and weighted by how often they occur.
+static PreflopTable::Cell computeCell(int heroClass, int villainClass)
+{
+    std::vector<std::array<int, Card::max_suits>> permutations {};
+    std::array<int, Card::max_suits> permutation {0, 1, 2, 3};
+    do
+    {
+        permutations.push_back(permutation);
+    } while (std::next_permutation(permutation.begin(), permutation.end()));
+
+    std::map<std::pair<std::uint64_t, std::uint64_t>, std::uint64_t> matchups {};
+    for (auto hero : classCombos(heroClass))
+    {
+        for (auto villain : classCombos(villainClass))
+        {
+            if (hero.intersects(villain))
+            {
+                continue;
+            }
+
+            std::pair<std::uint64_t, std::uint64_t> canonical {hero.mask, villain.mask};
+            for (const auto& suits : permutations)
+            {
+                canonical = std::min(canonical, std::pair {permuteSuits(hero, suits).mask,
+                    permuteSuits(villain, suits).mask});
+            }
+            ++matchups[canonical];
+        }
+    }
+
+    PreflopTable::Cell cell {};
+    for (const auto& [hands, count] : matchups)
+    {
+        Scenario scenario {};
+        scenario.numPlayers = 2;
+        scenario.numHands = 2;
+        scenario.players.resize(2);
+        scenario.players[0].hand = CardSet {hands.first};
+        scenario.players[1].hand = CardSet {hands.second};
+
+        auto result {enumerate(scenario, 1)};
+        cell.wins += count * static_cast<std::uint64_t>(result.wins);
+        cell.draws += count * static_cast<std::uint64_t>(result.draws);
+        cell.trials += count * static_cast<std::uint64_t>(result.trials);
+    }
+
+    return cell;
+}
+
+bool PreflopTable::generate(const std::string& path, unsigned threads)
+{
+    std::vector<Cell> cells(numCells);
+
+    {
+        ThreadPool pool {threads};
+        std::vector<std::pair<std::pair<int, int>, std::future<Cell>>> jobs {};
+        for (int hero {0}; hero < numClasses; ++hero)
+        {
+            for (int villain {hero}; villain < numClasses; ++villain)
+            {
+                jobs.emplace_back(std::pair {hero, villain}, pool.submit([hero, villain]
+                {
+                    return computeCell(hero, villain);
+                }));
+            }
+        }
+
+        std::size_t done {0};
+        for (auto& [classes, job] : jobs)
+        {
+            auto [hero, villain] {classes};
+            Cell cell {job.get()};
+            cells[static_cast<std::size_t>(hero * numClasses + villain)] = cell;
+
+            // The other seat's wins are this seat's losses
+            if (villain != hero)
+            {
+                Cell mirrored {cell.trials - cell.wins - cell.draws, cell.draws, cell.trials};
+                cells[static_cast<std::size_t>(villain * numClasses + hero)] = mirrored;
+            }
+
+            if (++done % 100 == 0)
+            {
+                std::cerr << "Preflop table: " << done << " of " << jobs.size() << " matchups\n";
+            }
+        }
+    }
+
+    for (int hero {0}; hero < numClasses; ++hero)
+    {
+        Cell& total {cells[static_cast<std::size_t>(numClasses * numClasses + hero)]};
+        for (int villain {0}; villain < numClasses; ++villain)
+        {
+            const Cell& cell {cells[static_cast<std::size_t>(hero * numClasses + villain)]};
+            total.wins += cell.wins;
+            total.draws += cell.draws;
+            total.trials += cell.trials;
+        }
+    }
+
+    std::ofstream out {path, std::ios::binary};
+    Header header {};
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(cells.data()), static_cast<std::streamsize>(cells.size() * sizeof(Cell)));
+    return static_cast<bool>(out);
+}
+
+PreflopTable::~PreflopTable()
+{
+    if (m_mapping)
+    {
+        munmap(m_mapping, m_size);
+    }
+}
+
+bool PreflopTable::open(const std::string& path)
+{
+    int file {::open(path.c_str(), O_RDONLY)};
+    if (file < 0)
+    {
+        return false;
+    }
+
+    struct stat info {};
+    std::size_t expected {sizeof(Header) + numCells * sizeof(Cell)};
+    if (fstat(file, &info) != 0 || static_cast<std::size_t>(info.st_size) != expected)
+    {
+        close(file);
+        return false;
+    }
+
+    void* mapping {mmap(nullptr, expected, PROT_READ, MAP_SHARED, file, 0)};
+    close(file);
+    if (mapping == MAP_FAILED)
+    {
+        return false;
+    }
+
+    Header expectedHeader {};
+    if (std::memcmp(mapping, &expectedHeader, sizeof(Header)) != 0)
+    {
+        munmap(mapping, expected);
+        return false;
+    }
+
+    if (m_mapping)
+    {
+        munmap(m_mapping, m_size);
+    }
+    m_mapping = mapping;
+    m_size = expected;
+    m_cells = reinterpret_cast<const Cell*>(static_cast<const char*>(mapping) + sizeof(Header));
+    return true;
+}
+
+const PreflopTable::Cell& PreflopTable::cell(int heroClass, int villainClass) const
+{
+    return m_cells[heroClass * numClasses + villainClass];
+}
+
+const PreflopTable::Cell& PreflopTable::againstRandom(int heroClass) const
+{
+    return m_cells[numClasses * numClasses + heroClass];
+}
+
+std::optional<EquityResult> PreflopTable::lookup(const Scenario& scenario) const
+{
+    // A class cell averages over suit combinations, which is only exact when the villain's suits are unknown too
+    if (!m_cells || scenario.numPlayers != 2 || scenario.numCommunal != 0 || scenario.numHands != 1 ||
+        !scenario.ranges.empty())
+    {
+        return std::nullopt;
+    }
+
+    const Cell& found {againstRandom(handClass(scenario.players[0].hand))};
+
+    EquityResult result {};
+    result.wins = static_cast<std::int64_t>(found.wins);
+    result.draws = static_cast<std::int64_t>(found.draws);
+    result.trials = static_cast<std::int64_t>(found.trials);
+    result.equityTotal = static_cast<double>(found.wins) + 0.5 * static_cast<double>(found.draws);
+    result.equitySquares = static_cast<double>(found.wins) + 0.25 * static_cast<double>(found.draws);
+    result.method = EquityResult::preflop_table;
+    return result;
+}
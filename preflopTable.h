@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include "deck.h"
+#include "simulation.h"
+
+// Exact heads-up all-in results for every pair of the 169 starting hand classes, generated once and memory-mapped.
+// A cell holds the win, draw and showdown counts summed over every non-overlapping pair of combos from the two
+// classes and every board, so it is the average over their suit combinations: exact for a hand against a random
+// hand, which suit symmetry makes the same for every combo of a class, but not for two specific hands.
+// The file is a Header followed by the 169x169 cells (hero class by villain class) and then 169 cells of each class
+// against a random hand, stored in native byte order so it can be used in place.
+class PreflopTable
+{
+    public:
+        static constexpr int numClasses {169};
+
+        struct Cell
+        {
+            std::uint64_t wins {};
+            std::uint64_t draws {};
+            std::uint64_t trials {};
+        };
+
+        struct Header
+        {
+            char magic[8] {'P', 'F', 'E', 'Q', 'v', '1', '\0', '\0'};
+            std::uint32_t classes {numClasses};
+            std::uint32_t cellSize {sizeof(Cell)};
+        };
+
+        // high * 13 + low for suited hands, low * 13 + high for offsuit hands and value * 14 for pairs
+        static int handClass(CardSet hand);
+
+        // Computes every cell with enumerate() and writes the file, returning false if it could not be written
+        static bool generate(const std::string& path, unsigned threads);
+
+        PreflopTable() = default;
+        ~PreflopTable();
+        PreflopTable(const PreflopTable&) = delete;
+        PreflopTable& operator=(const PreflopTable&) = delete;
+
+        // Maps path, returning false if it is missing or not a preflop table
+        bool open(const std::string& path);
+        bool isOpen() const { return m_cells != nullptr; }
+
+        const Cell& cell(int heroClass, int villainClass) const;
+        const Cell& againstRandom(int heroClass) const;
+
+        // Answers a known hero hand against one random hand with no board and no ranges, the only spots the
+        // class results give exactly
+        std::optional<EquityResult> lookup(const Scenario& scenario) const;
+
+    private:
+        void* m_mapping {nullptr};
+        std::size_t m_size {0};
+        const Cell* m_cells {nullptr};
+};
@@ -0,0 +1,315 @@
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <x86intrin.h>
+#define TSC_TICKS
+#endif
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#include "pokerGame.h"
+#include "profile.h"
+
+namespace
+{
+    std::mutex finishedMutex {};
+    Profile::Counters finished {};
+
+    // Adds a thread's counters to the totals as it exits
+    struct ThreadCounters
+    {
+        Profile::Counters counters {};
+
+        ~ThreadCounters()
+        {
+            std::lock_guard lock {finishedMutex};
+            finished += counters;
+        }
+    };
+
+    thread_local ThreadCounters threadCounters {};
+
+    // The rate of ticks() is measured over the run so far, from this starting point
+    const auto startTicks {Profile::ticks()};
+    const auto startTime {std::chrono::steady_clock::now()};
+
+    constexpr std::array rankingKeys {"high_card", "pair", "two_pair", "three_kind", "straight", "flush", "full_house",
+        "four_kind", "straight_flush"};
+}
+
+const char* Profile::stageName(Stage stage)
+{
+    static constexpr std::array names {"deal", "stage", "evaluate", "showdown", "enumerate", "sort"};
+    return names[stage];
+}
+
+Profile::Counters& Profile::Counters::operator+=(const Counters& other)
+{
+    for (std::size_t i {0}; i < ticks.size(); ++i)
+    {
+        ticks[i] += other.ticks[i];
+        calls[i] += other.calls[i];
+    }
+    for (std::size_t i {0}; i < categories.size(); ++i)
+    {
+        categories[i] += other.categories[i];
+    }
+    return *this;
+}
+
+Profile::Counters& Profile::local()
+{
+    return threadCounters.counters;
+}
+
+Profile::Counters Profile::totals()
+{
+    std::lock_guard lock {finishedMutex};
+    auto result {finished};
+    result += local();
+    return result;
+}
+
+void Profile::reset()
+{
+    std::lock_guard lock {finishedMutex};
+    finished = {};
+    local() = {};
+}
+
+std::uint64_t Profile::ticks()
+{
+#ifdef TSC_TICKS
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+double Profile::ticksPerSecond()
+{
+#ifdef TSC_TICKS
+    // A short run is stretched to 20 ms so that the rate is measured to within a fraction of a percent
+    std::this_thread::sleep_until(startTime + std::chrono::milliseconds {20});
+    std::chrono::duration<double> elapsed {std::chrono::steady_clock::now() - startTime};
+    return static_cast<double>(ticks() - startTicks) / elapsed.count();
+#else
+    return 1e9;
+#endif
+}
+
+const char* Profile::Hardware::eventName(Event event)
+{
+    static constexpr std::array names {"cycles", "instructions", "cache_misses", "branch_misses"};
+    return names[event];
+}
+
+Profile::Hardware::Hardware()
+{
+#ifdef __linux__
+    static constexpr std::array<std::uint64_t, max_events> configs {PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+
+    for (std::size_t i {0}; i < configs.size(); ++i)
+    {
+        perf_event_attr attributes {};
+        attributes.type = PERF_TYPE_HARDWARE;
+        attributes.size = sizeof(attributes);
+        attributes.config = configs[i];
+        attributes.disabled = 1;
+        attributes.inherit = 1;
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv = 1;
+        m_fds[i] = static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+    }
+#endif
+}
+
+Profile::Hardware::~Hardware()
+{
+#ifdef __linux__
+    for (auto fd : m_fds)
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+    }
+#endif
+}
+
+bool Profile::Hardware::available() const
+{
+    for (auto fd : m_fds)
+    {
+        if (fd >= 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Profile::Hardware::start()
+{
+#ifdef __linux__
+    for (auto fd : m_fds)
+    {
+        if (fd >= 0)
+        {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#endif
+}
+
+Profile::Hardware::Reading Profile::Hardware::read() const
+{
+    Reading reading {};
+#ifdef __linux__
+    for (std::size_t i {0}; i < m_fds.size(); ++i)
+    {
+        std::uint64_t count {};
+        if (m_fds[i] >= 0 && ::read(m_fds[i], &count, sizeof(count)) == sizeof(count))
+        {
+            reading[i] = count;
+        }
+    }
+#endif
+    return reading;
+}
+
+std::string Profile::json(const Counters& counters, const Hardware::Reading* hardware)
+{
+    std::string result {};
+    char buffer[160] {};
+    double rate {ticksPerSecond()};
+    std::snprintf(buffer, sizeof(buffer), "{\"ticks_per_second\": %.0f, \"stages\": ", rate);
+    result += buffer;
+
+    auto countsByRanking = [&](const std::array<std::uint64_t, Settings::max_rankings>& counts)
+    {
+        result += '{';
+        for (std::size_t i {0}; i < counts.size(); ++i)
+        {
+            std::snprintf(buffer, sizeof(buffer), "%s\"%s\": %llu", (i == 0) ? "" : ", ", rankingKeys[i],
+                static_cast<unsigned long long>(counts[i]));
+            result += buffer;
+        }
+        result += '}';
+    };
+
+    if (enabled)
+    {
+        result += '{';
+        for (int stage {0}; stage < max_stages; ++stage)
+        {
+            std::snprintf(buffer, sizeof(buffer), "%s\"%s\": {\"calls\": %llu, \"ticks\": %llu, \"seconds\": %.6f}",
+                (stage == 0) ? "" : ", ", stageName(static_cast<Stage>(stage)),
+                static_cast<unsigned long long>(counters.calls[stage]),
+                static_cast<unsigned long long>(counters.ticks[stage]), static_cast<double>(counters.ticks[stage]) / rate);
+            result += buffer;
+        }
+        result += "}, \"categories\": ";
+        countsByRanking(counters.categories);
+    }
+    else
+    {
+        result += "null, \"categories\": null";
+    }
+
+    result += ", \"hardware\": ";
+    if (hardware)
+    {
+        result += '{';
+        for (int event {0}; event < Hardware::max_events; ++event)
+        {
+            const auto& count {(*hardware)[static_cast<std::size_t>(event)]};
+            auto name {Hardware::eventName(static_cast<Hardware::Event>(event))};
+            if (count)
+            {
+                std::snprintf(buffer, sizeof(buffer), "\"%s\": %llu", name, static_cast<unsigned long long>(*count));
+            }
+            else
+            {
+                std::snprintf(buffer, sizeof(buffer), "\"%s\": null", name);
+            }
+            result += (event == 0) ? "" : ", ";
+            result += buffer;
+        }
+        result += '}';
+    }
+    else
+    {
+        result += "null";
+    }
+    return result + "}";
+}
+
+void Profile::print(std::ostream& out, const Counters& counters, const Hardware::Reading* hardware)
+{
+    char buffer[160] {};
+    if (enabled)
+    {
+        double rate {ticksPerSecond()};
+        out << "Stage          calls        seconds   ticks/call\n";
+        for (int stage {0}; stage < max_stages; ++stage)
+        {
+            auto calls {counters.calls[stage]};
+            auto ticks {counters.ticks[stage]};
+            std::snprintf(buffer, sizeof(buffer), "%-10s %12llu %12.6f %12.1f\n", stageName(static_cast<Stage>(stage)),
+                static_cast<unsigned long long>(calls), static_cast<double>(ticks) / rate,
+                (calls > 0) ? static_cast<double>(ticks) / static_cast<double>(calls) : 0.0);
+            out << buffer;
+        }
+
+        std::uint64_t scored {0};
+        for (auto count : counters.categories)
+        {
+            scored += count;
+        }
+
+        out << "Category          evaluated\n";
+        for (int ranking {Settings::max_rankings - 1}; ranking >= 0; --ranking)
+        {
+            auto evaluated {counters.categories[static_cast<std::size_t>(ranking)]};
+            std::snprintf(buffer, sizeof(buffer), "%-15s %12llu %5.1f%%\n", rankingKeys[ranking],
+                static_cast<unsigned long long>(evaluated),
+                (scored > 0) ? 100.0 * static_cast<double>(evaluated) / static_cast<double>(scored) : 0.0);
+            out << buffer;
+        }
+    }
+    else
+    {
+        out << "Stage counters need a build with -DPROFILE_STAGES\n";
+    }
+
+    if (hardware)
+    {
+        for (int event {0}; event < Hardware::max_events; ++event)
+        {
+            const auto& count {(*hardware)[static_cast<std::size_t>(event)]};
+            out << Hardware::eventName(static_cast<Hardware::Event>(event)) << ": ";
+            if (count)
+            {
+                out << *count << '\n';
+            }
+            else
+            {
+                out << "unavailable\n";
+            }
+        }
+    }
+}
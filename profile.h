@@ -0,0 +1,140 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include "pokerGame.h"
+
+// Building with -DPROFILE_STAGES times each stage of the simulation hot path and counts the evaluator's results, so a
+// slow run shows where its time goes. Otherwise Scope and the count functions compile to nothing and every counter
+// stays at zero. Hardware counters work in any build.
+namespace Profile
+{
+#ifdef PROFILE_STAGES
+    constexpr bool enabled {true};
+#else
+    constexpr bool enabled {false};
+#endif
+
+    enum Stage
+    {
+        deal,           // drawing each sampled trial's unknown cards
+        stage,          // handing staged deals to the batch evaluator
+        evaluate,       // the batch evaluator's kernels
+        showdown,       // comparing the seats of the evaluated trials
+        enumerate,      // a whole enumeration worker, its evaluations included
+        sort,           // sorting strengths for strength distributions
+
+        max_stages
+    };
+
+    const char* stageName(Stage stage);
+
+    struct Counters
+    {
+        std::array<std::uint64_t, max_stages> ticks {};
+        std::array<std::uint64_t, max_stages> calls {};
+
+        // Hands the evaluator scored in each category
+        std::array<std::uint64_t, Settings::max_rankings> categories {};
+
+        Counters& operator+=(const Counters& other);
+    };
+
+    // The calling thread's counters, added to the totals when the thread exits
+    Counters& local();
+
+    // Everything counted since the last reset() by threads that have exited and by the calling thread
+    Counters totals();
+    void reset();
+
+    // TSC ticks on x86-64 and nanoseconds elsewhere, with the rate measured against the steady clock
+    std::uint64_t ticks();
+    double ticksPerSecond();
+
+    // Times one stage from construction to destruction, in the calling thread's counters
+    class Scope
+    {
+        public:
+            explicit Scope([[maybe_unused]] Stage stage)
+            {
+                if constexpr (enabled)
+                {
+                    m_stage = stage;
+                    m_start = ticks();
+                }
+            }
+
+            ~Scope()
+            {
+                if constexpr (enabled)
+                {
+                    auto& counters {local()};
+                    counters.ticks[m_stage] += ticks() - m_start;
+                    ++counters.calls[m_stage];
+                }
+            }
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+        private:
+            Stage m_stage {};
+            std::uint64_t m_start {};
+    };
+
+    inline void countCategory([[maybe_unused]] Settings::Rankings category)
+    {
+        if constexpr (enabled)
+        {
+            ++local().categories[category];
+        }
+    }
+
+    // Linux perf_event counters for the calling thread and the threads it starts while they run, user space only.
+    // Events the kernel or the machine does not allow are left out.
+    class Hardware
+    {
+        public:
+            enum Event
+            {
+                cycles,
+                instructions,
+                cache_misses,
+                branch_misses,
+
+                max_events
+            };
+
+            using Reading = std::array<std::optional<std::uint64_t>, max_events>;
+
+            static const char* eventName(Event event);
+
+            Hardware();
+            ~Hardware();
+
+            Hardware(const Hardware&) = delete;
+            Hardware& operator=(const Hardware&) = delete;
+
+            bool available() const;
+
+            // Zeroes the counters and starts them; read() then gives the counts since, from threads that have exited
+            // and the calling thread
+            void start();
+            Reading read() const;
+
+        private:
+            std::array<int, max_events> m_fds {-1, -1, -1, -1};
+    };
+
+    // The counters, and a hardware reading when there is one, as a JSON object:
+    //     {"ticks_per_second": r, "stages": {"deal": {"calls": n, "ticks": t, "seconds": s}, ...},
+    //      "categories": {"high_card": n, ...}, "hardware": {"cycles": n, ...}}
+    // stages and categories are null without -DPROFILE_STAGES, and hardware is null without a reading.
+    std::string json(const Counters& counters, const Hardware::Reading* hardware = nullptr);
+
+    // The same as a table, one line per stage, category and event
+    void print(std::ostream& out, const Counters& counters, const Hardware::Reading* hardware = nullptr);
+}
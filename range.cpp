@@ -0,0 +1,261 @@
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "deck.h"
+#include "rng.h"
+#include "range.h"
+
+struct HandClass
+{
+    int high {};
+    int low {};
+    char kind {};   // 'p' pair, 's' suited, 'o' offsuit, 'b' both suited and offsuit
+};
+
+static std::string_view trim(std::string_view text)
+{
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.front())))
+    {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.back())))
+    {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+// Reads "AK", "AKs", "AKo" or "TT"
+static std::optional<HandClass> parseClass(std::string_view text)
+{
+    if (text.size() < 2 || text.size() > 3)
+    {
+        return std::nullopt;
+    }
+
+    int first {Card::valueFromChar(text[0])};
+    int second {Card::valueFromChar(text[1])};
+    if (first < 0 || second < 0)
+    {
+        return std::nullopt;
+    }
+
+    HandClass hand {std::max(first, second), std::min(first, second), 'b'};
+    if (first == second)
+    {
+        hand.kind = 'p';
+        return (text.size() == 2) ? std::optional {hand} : std::nullopt;
+    }
+
+    if (text.size() == 3)
+    {
+        char kind {static_cast<char>(std::tolower(static_cast<unsigned char>(text[2])))};
+        if (kind != 's' && kind != 'o')
+        {
+            return std::nullopt;
+        }
+        hand.kind = kind;
+    }
+
+    return hand;
+}
+
+void Range::add(CardSet cards, double weight, ComboIndex& index)
+{
+    auto low {static_cast<std::size_t>(std::countr_zero(cards.mask))};
+    auto high {static_cast<std::size_t>(63 - std::countl_zero(cards.mask))};
+    auto& slot {index[low * 52 + high]};
+    if (slot >= 0)
+    {
+        m_combos[static_cast<std::size_t>(slot)].weight = weight;
+        return;
+    }
+
+    slot = static_cast<std::int16_t>(m_combos.size());
+    m_combos.push_back(Combo {cards, weight});
+}
+
+void Range::addClass(int high, int low, char kind, double weight, ComboIndex& index)
+{
+    for (int suit1 {0}; suit1 < Card::max_suits; ++suit1)
+    {
+        for (int suit2 {0}; suit2 < Card::max_suits; ++suit2)
+        {
+            bool suited {suit1 == suit2};
+            if ((kind == 'p' && suit2 <= suit1) || (kind == 's' && !suited) || (kind == 'o' && suited))
+            {
+                continue;
+            }
+
+            CardSet cards {CardSet::bit(static_cast<CardCode>(suit1 * Card::max_ranks + high)) |
+                CardSet::bit(static_cast<CardCode>(suit2 * Card::max_ranks + low))};
+            add(cards, weight, index);
+        }
+    }
+}
+
+std::optional<Range> Range::parse(std::string_view text)
+{
+    Range range {};
+    ComboIndex index(52 * 52, -1);
+
+    while (!text.empty())
+    {
+        auto comma {text.find(',')};
+        auto item {trim(text.substr(0, comma))};
+        text = (comma == std::string_view::npos) ? std::string_view {} : text.substr(comma + 1);
+
+        if (item.empty())
+        {
+            continue;
+        }
+
+        double weight {1.0};
+        if (auto colon {item.find(':')}; colon != std::string_view::npos)
+        {
+            std::string weightText {trim(item.substr(colon + 1))};
+            char* end {};
+            weight = std::strtod(weightText.c_str(), &end);
+            if (weightText.empty() || *end != '\0' || !std::isfinite(weight) || weight < 0)
+            {
+                return std::nullopt;
+            }
+            item = trim(item.substr(0, colon));
+        }
+
+        // An exact hand such as AsKs
+        if (item.size() == 4 && item.back() != '+')
+        {
+            auto card1 {Card::fromString(item.substr(0, 2))};
+            auto card2 {Card::fromString(item.substr(2, 2))};
+            if (!card1 || !card2 || *card1 == *card2)
+            {
+                return std::nullopt;
+            }
+            range.add(CardSet {*card1, *card2}, weight, index);
+            continue;
+        }
+
+        bool plus {item.back() == '+'};
+        if (plus)
+        {
+            item.remove_suffix(1);
+        }
+
+        auto dash {item.find('-')};
+        auto first {parseClass(trim(item.substr(0, dash)))};
+        if (!first)
+        {
+            return std::nullopt;
+        }
+
+        HandClass last {*first};
+        if (dash != std::string_view::npos)
+        {
+            auto other {parseClass(trim(item.substr(dash + 1)))};
+            if (plus || !other || other->kind != first->kind ||
+                (first->kind != 'p' && other->high != first->high))
+            {
+                return std::nullopt;
+            }
+            last = *other;
+        }
+        else if (plus)
+        {
+            // TT+ climbs to aces, A2s+ climbs the kicker up to one below the top card
+            last.high = (first->kind == 'p') ? Card::max_ranks - 1 : first->high;
+            last.low = (first->kind == 'p') ? Card::max_ranks - 1 : first->high - 1;
+        }
+
+        if (first->kind == 'p')
+        {
+            for (int value {std::min(first->high, last.high)}; value <= std::max(first->high, last.high); ++value)
+            {
+                range.addClass(value, value, 'p', weight, index);
+            }
+        }
+        else
+        {
+            for (int low {std::min(first->low, last.low)}; low <= std::max(first->low, last.low); ++low)
+            {
+                range.addClass(first->high, low, first->kind, weight, index);
+            }
+        }
+    }
+
+    return range;
+}
+
+RangeSampler::RangeSampler(const Range& range, CardSet deadCards)
+{
+    std::vector<double> weights {};
+    for (const auto& combo : range.combos())
+    {
+        if (!combo.cards.intersects(deadCards) && combo.weight > 0)
+        {
+            m_combos.push_back(combo.cards);
+            weights.push_back(combo.weight);
+        }
+    }
+
+    // Vose's alias method: every slot keeps its own combo with m_probability and otherwise gives its alias
+    std::size_t size {m_combos.size()};
+    m_probability.resize(size);
+    m_alias.resize(size);
+
+    double total {0};
+    for (auto weight : weights)
+    {
+        total += weight;
+    }
+
+    std::vector<std::uint32_t> small {};
+    std::vector<std::uint32_t> large {};
+    for (std::size_t i {0}; i < size; ++i)
+    {
+        weights[i] = weights[i] * static_cast<double>(size) / total;
+        (weights[i] < 1.0 ? small : large).push_back(static_cast<std::uint32_t>(i));
+    }
+
+    while (!small.empty() && !large.empty())
+    {
+        auto less {small.back()};
+        small.pop_back();
+        auto more {large.back()};
+
+        m_probability[less] = weights[less];
+        m_alias[less] = more;
+
+        weights[more] -= 1.0 - weights[less];
+        if (weights[more] < 1.0)
+        {
+            large.pop_back();
+            small.push_back(more);
+        }
+    }
+
+    for (auto i : large)
+    {
+        m_probability[i] = 1.0;
+        m_alias[i] = i;
+    }
+    for (auto i : small)
+    {
+        m_probability[i] = 1.0;
+        m_alias[i] = i;
+    }
+}
+
+CardSet RangeSampler::sample(Xoshiro256& rng) const
+{
+    auto slot {rng.below(static_cast<std::uint32_t>(m_combos.size()))};
+    bool keep {rng.uniform() < m_probability[slot]};
+    return m_combos[keep ? slot : m_alias[slot]];
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+#include "deck.h"
+#include "rng.h"
+
+struct Combo
+{
+    CardSet cards {};
+    double weight {1.0};
+};
+
+// A hand range in the usual notation, expanded to every hole-card combination it contains.
+// Comma separated items: pairs (TT, TT+, TT-77), suited or offsuit hands (AKs, KQo, AK for both, A2s+, A5s-A2s)
+// and exact hands (AsKs), each optionally weighted with :weight (AKo:0.5). A combo listed twice keeps its last weight.
+class Range
+{
+    private:
+        std::vector<Combo> m_combos {};
+
+        // Each combo's index in m_combos by its two card codes, low code first, or -1, while parsing
+        using ComboIndex = std::vector<std::int16_t>;
+
+        void add(CardSet cards, double weight, ComboIndex& index);
+        void addClass(int high, int low, char kind, double weight, ComboIndex& index);
+
+    public:
+        static std::optional<Range> parse(std::string_view text);
+
+        const std::vector<Combo>& combos() const { return m_combos; }
+        bool empty() const { return m_combos.empty(); }
+};
+
+// Weighted sampling from a range through an alias table, so each draw costs O(1) however wide the range is.
+// Combos that hit the dead cards are dropped when the table is built.
+class RangeSampler
+{
+    private:
+        std::vector<CardSet> m_combos {};
+        std::vector<double> m_probability {};
+        std::vector<std::uint32_t> m_alias {};
+
+    public:
+        RangeSampler(const Range& range, CardSet deadCards);
+
+        bool empty() const { return m_combos.empty(); }
+        const std::vector<CardSet>& combos() const { return m_combos; }
+
+        CardSet sample(Xoshiro256& rng) const;
+};
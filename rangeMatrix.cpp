@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "deck.h"
+#include "handStrength.h"
+#include "range.h"
+#include "rng.h"
+#include "rangeMatrix.h"
+
+double RangeMatrix::Cell::equity() const
+{
+    return (runouts > 0) ? (wins + 0.5 * draws) / runouts : 0.0;
+}
+
+RangeMatrix RangeMatrix::compute(const Range& hero, const Range& villain, CardSet board, unsigned threads,
+    Xoshiro256& rng, std::int64_t maxRunouts)
+{
+    assert(board.size() <= 5 && maxRunouts > 0);
+
+    RangeMatrix matrix {};
+    matrix.m_hero = hero.combos();
+    matrix.m_villain = villain.combos();
+    matrix.m_board = board;
+    matrix.m_cells.resize(matrix.rows() * matrix.columns());
+
+    auto boards {boardRunouts(board, maxRunouts, rng, matrix.m_exact)};
+    matrix.m_runouts = static_cast<std::uint32_t>(boards.size());
+
+    const auto& heroCombos {matrix.m_hero};
+    const auto& villainCombos {matrix.m_villain};
+    auto columns {matrix.columns()};
+
+    // Each worker owns a contiguous block of rows, so cells are never shared and need no merging. Villain's
+    // combos are scored by every worker, which is cheap next to the rows x columns comparisons.
+    auto work = [&](std::size_t firstRow, std::size_t endRow)
+    {
+        std::vector<HandStrength::Strength> villainStrength(columns);
+        std::vector<std::size_t> liveColumns {};
+        std::vector<std::size_t> liveRows {};
+        HandStrength::Batch batch {};
+
+        for (auto runout : boards)
+        {
+            // The live villain combos, then the live rows, are scored in one batch
+            batch.clear();
+            batch.setBoard(runout);
+            liveColumns.clear();
+            for (std::size_t column {0}; column < columns; ++column)
+            {
+                if (!villainCombos[column].cards.intersects(runout))
+                {
+                    batch.add(villainCombos[column].cards);
+                    liveColumns.push_back(column);
+                }
+            }
+
+            liveRows.clear();
+            for (std::size_t row {firstRow}; row < endRow; ++row)
+            {
+                if (!heroCombos[row].cards.intersects(runout))
+                {
+                    batch.add(heroCombos[row].cards);
+                    liveRows.push_back(row);
+                }
+            }
+
+            batch.evaluate();
+            for (std::size_t i {0}; i < liveColumns.size(); ++i)
+            {
+                villainStrength[liveColumns[i]] = batch.strength(i);
+            }
+
+            for (std::size_t i {0}; i < liveRows.size(); ++i)
+            {
+                auto row {liveRows[i]};
+                CardSet heroCards {heroCombos[row].cards};
+                auto heroStrength {batch.strength(liveColumns.size() + i)};
+                Cell* cells {&matrix.m_cells[row * columns]};
+                for (auto column : liveColumns)
+                {
+                    if (heroCards.intersects(villainCombos[column].cards))
+                    {
+                        continue;
+                    }
+
+                    Cell& cell {cells[column]};
+                    ++cell.runouts;
+                    cell.wins += heroStrength > villainStrength[column];
+                    cell.draws += heroStrength == villainStrength[column];
+                }
+            }
+        }
+    };
+
+    auto rows {matrix.rows()};
+    threads = static_cast<unsigned>(std::clamp<std::size_t>(threads, 1, std::max<std::size_t>(rows, 1)));
+
+    std::vector<std::thread> workers {};
+    for (unsigned t {1}; t < threads; ++t)
+    {
+        workers.emplace_back(work, rows * t / threads, rows * (t + 1) / threads);
+    }
+    work(0, rows / threads);
+
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+
+    return matrix;
+}
+
+bool RangeMatrix::write(const std::string& path) const
+{
+    std::ofstream out {path, std::ios::binary};
+
+    Header header {};
+    header.rows = static_cast<std::uint32_t>(rows());
+    header.columns = static_cast<std::uint32_t>(columns());
+    header.board = m_board.mask;
+    header.runouts = m_runouts;
+    header.exact = m_exact ? 1 : 0;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    for (const auto* combos : {&m_hero, &m_villain})
+    {
+        for (const auto& combo : *combos)
+        {
+            CardCode codes[2] {};
+            int i {0};
+            combo.cards.forEach([&](Card card) { codes[i++] = card.code(); });
+
+            auto weight {static_cast<float>(combo.weight)};
+            out.write(reinterpret_cast<const char*>(codes), sizeof(codes));
+            out.write(reinterpret_cast<const char*>(&weight), sizeof(weight));
+        }
+    }
+
+    std::vector<float> equities(m_cells.size());
+    std::transform(m_cells.begin(), m_cells.end(), equities.begin(),
+        [](const Cell& cell) { return static_cast<float>(cell.equity()); });
+    out.write(reinterpret_cast<const char*>(equities.data()), static_cast<std::streamsize>(equities.size() * sizeof(float)));
+
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "deck.h"
+#include "range.h"
+#include "rng.h"
+
+// Heads-up equity of every combo of one range against every combo of another on a fixed board.
+// Each runout is scored once for all live combos of both ranges, then every pair of combos that does not share a
+// card is compared. Runouts are enumerated when there are at most maxRunouts of them and sampled otherwise, the
+// same sampled runouts serving every cell. Cells whose combos share a card with each other or with the board have
+// no runouts and an equity of zero.
+class RangeMatrix
+{
+    public:
+        static constexpr std::int64_t defaultMaxRunouts {20000};
+
+        struct Cell
+        {
+            std::uint32_t wins {};
+            std::uint32_t draws {};
+            std::uint32_t runouts {};
+
+            double equity() const;
+        };
+
+        // Rows follow hero's combos and columns villain's, in range order. Rows are split across threads, and
+        // sampled runouts are drawn from rng.
+        static RangeMatrix compute(const Range& hero, const Range& villain, CardSet board, unsigned threads,
+            Xoshiro256& rng, std::int64_t maxRunouts = defaultMaxRunouts);
+
+        std::size_t rows() const { return m_hero.size(); }
+        std::size_t columns() const { return m_villain.size(); }
+        const Cell& cell(std::size_t row, std::size_t column) const { return m_cells[row * m_villain.size() + column]; }
+        const std::vector<Combo>& heroCombos() const { return m_hero; }
+        const std::vector<Combo>& villainCombos() const { return m_villain; }
+        bool exact() const { return m_exact; }
+
+        // The file is a Header, then for hero's and then villain's combos their two card codes and float weight,
+        // then the rows x columns hero equities as floats, row by row, all in native byte order.
+        bool write(const std::string& path) const;
+
+        struct Header
+        {
+            char magic[8] {'R', 'V', 'R', 'M', 'v', '1', '\0', '\0'};
+            std::uint32_t rows {};
+            std::uint32_t columns {};
+            std::uint64_t board {};
+            std::uint32_t runouts {};
+            std::uint32_t exact {};
+        };
+
+    private:
+        std::vector<Combo> m_hero {};
+        std::vector<Combo> m_villain {};
+        std::vector<Cell> m_cells {};
+        CardSet m_board {};
+        std::uint32_t m_runouts {};
+        bool m_exact {true};
+};
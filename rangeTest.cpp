@@ -0,0 +1,85 @@
+#include <iostream>
+#include <optional>
+#include <string_view>
+#include "range.h"
+
+// Checks Range::parse on a fixed table of range texts: how many combos each one expands to and the weight they get,
+// or that it is rejected. Exits with 1 and prints the cases that fail.
+namespace
+{
+    struct Case
+    {
+        std::string_view text {};
+        std::optional<std::size_t> combos {};   // nothing when parse() must reject the text
+        double weight {1.0};                    // of the first combo
+    };
+
+    constexpr Case cases[]
+    {
+        {"AA", 6},
+        {"AKs", 4},
+        {"AKo", 12},
+        {"AK", 16},
+        {"AsKs", 1},
+        {"TT+", 30},
+        {"TT-77", 24},
+        {"A2s+", 48},
+        {"A5s-A2s", 16},
+        {" QQ+ , AKs ", 22},
+        {"AKo:0.5", 12, 0.5},
+        {"AKs:0", 4, 0.0},
+        {"AKs, AsKs:0.25", 4},
+        {"AKs:nan", std::nullopt},
+        {"AKs:NAN", std::nullopt},
+        {"AKs:inf", std::nullopt},
+        {"AKs:-inf", std::nullopt},
+        {"AKs:infinity", std::nullopt},
+        {"AKs:1e999", std::nullopt},
+        {"AKs:-1", std::nullopt},
+        {"AKs:", std::nullopt},
+        {"AKs:0.5x", std::nullopt},
+        {"AsAs", std::nullopt},
+        {"AKx", std::nullopt},
+        {"ZZ", std::nullopt},
+    };
+}
+
+int main()
+{
+    int failures {0};
+    for (const auto& test : cases)
+    {
+        auto range {Range::parse(test.text)};
+        bool passed {test.combos ? (range && range->combos().size() == *test.combos &&
+            range->combos().front().weight == test.weight) : !range};
+        if (passed)
+        {
+            continue;
+        }
+
+        ++failures;
+        std::cout << '"' << test.text << "\" gave ";
+        if (range)
+        {
+            std::cout << range->combos().size() << " combos";
+            if (!range->combos().empty())
+            {
+                std::cout << " of weight " << range->combos().front().weight;
+            }
+        }
+        else
+        {
+            std::cout << "no range";
+        }
+        std::cout << '\n';
+    }
+
+    if (failures > 0)
+    {
+        std::cout << failures << " of " << std::size(cases) << " range texts failed\n";
+        return 1;
+    }
+
+    std::cout << "All " << std::size(cases) << " range texts parse as expected\n";
+    return 0;
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <random>
+
+// xoshiro256** (Blackman and Vigna): 32 bytes of state and a few instructions per 64-bit output, which is much
+// cheaper than std::mt19937 with std::uniform_int_distribution. Satisfies UniformRandomBitGenerator.
+//
+// Everything random in the engine draws from a generator passed in by the caller, so a run is reproducible from its
+// seed. Work split across threads takes one generator per worker from split(), and independent jobs such as batch
+// lines take stream(seed, index), so results depend only on the seed and the thread count.
+class Xoshiro256
+{
+    private:
+        std::uint64_t m_state[4] {};
+
+        static constexpr std::uint64_t rotl(std::uint64_t x, int k)
+        {
+            return (x << k) | (x >> (64 - k));
+        }
+
+        static constexpr std::uint64_t splitmix(std::uint64_t x)
+        {
+            x += 0x9E3779B97F4A7C15;
+            x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9;
+            x = (x ^ (x >> 27)) * 0x94D049BB133111EB;
+            return x ^ (x >> 31);
+        }
+
+    public:
+        using result_type = std::uint64_t;
+
+        // The state is filled from seed with splitmix64, as the authors recommend
+        explicit constexpr Xoshiro256(std::uint64_t seed)
+        {
+            for (auto& word : m_state)
+            {
+                word = splitmix(seed);
+                seed += 0x9E3779B97F4A7C15;
+            }
+        }
+
+        static constexpr result_type min() { return 0; }
+        static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+        constexpr result_type operator()()
+        {
+            std::uint64_t result {rotl(m_state[1] * 5, 7) * 9};
+            std::uint64_t shifted {m_state[1] << 17};
+
+            m_state[2] ^= m_state[0];
+            m_state[3] ^= m_state[1];
+            m_state[1] ^= m_state[2];
+            m_state[0] ^= m_state[3];
+            m_state[2] ^= shifted;
+            m_state[3] = rotl(m_state[3], 45);
+
+            return result;
+        }
+
+        // Uniform in [0, bound) by Lemire's multiply-shift. The bias is below bound / 2^32, far under anything a
+        // simulation can detect, so there is no rejection step.
+        constexpr std::uint32_t below(std::uint32_t bound)
+        {
+            return static_cast<std::uint32_t>(((operator()() >> 32) * bound) >> 32);
+        }
+
+        // Uniform in [0, 1)
+        constexpr double uniform()
+        {
+            return static_cast<double>(operator()() >> 11) * 0x1.0p-53;
+        }
+
+        // Advances the state as if 2^128 outputs had been drawn, with the authors' jump polynomial
+        constexpr void jump()
+        {
+            constexpr std::uint64_t polynomial[] {0x180EC6D33CFD0ABA, 0xD5A61266F0C9392C, 0xA9582618E03FC9AA,
+                0x39ABDC4529B1661C};
+
+            std::uint64_t jumped[4] {};
+            for (auto word : polynomial)
+            {
+                for (int bit {0}; bit < 64; ++bit)
+                {
+                    if (word & (std::uint64_t {1} << bit))
+                    {
+                        for (int i {0}; i < 4; ++i)
+                        {
+                            jumped[i] ^= m_state[i];
+                        }
+                    }
+                    operator()();
+                }
+            }
+
+            for (int i {0}; i < 4; ++i)
+            {
+                m_state[i] = jumped[i];
+            }
+        }
+
+        // A generator for another worker: a copy of this one, which then jumps ahead, so the two sequences cannot
+        // overlap within 2^128 draws. Splitting n workers off one generator gives the same n streams every time.
+        constexpr Xoshiro256 split()
+        {
+            Xoshiro256 child {*this};
+            jump();
+            return child;
+        }
+
+        // Generator index of the family for seed, made in constant time by hashing the two together, for
+        // independent jobs that must not depend on the order they run in
+        static constexpr Xoshiro256 stream(std::uint64_t seed, std::uint64_t index)
+        {
+            return Xoshiro256 {splitmix(seed ^ splitmix(index + 0x632BE59BD9B4E019))};
+        }
+};
+
+// A seed from the operating system, for runs that were not given one
+inline std::uint64_t entropySeed()
+{
+    std::random_device device {};
+    return (std::uint64_t {device()} << 32) | device();
+}
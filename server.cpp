@@ -0,0 +1,379 @@
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "batch.h"
+#include "deck.h"
+#include "handStrength.h"
+#include "rng.h"
+#include "simulation.h"
+#include "threadPool.h"
+#include "server.h"
+
+namespace
+{
+    // A line this long without a newline ends the connection
+    constexpr std::size_t maxLine {1 << 16};
+
+    // A connection with this many replies outstanding is not read from again until some have been written
+    constexpr std::size_t maxPending {4096};
+
+    struct Reply
+    {
+        std::string text {};
+        std::atomic<bool> done {false};
+    };
+
+    void wakeUp(int fd)
+    {
+        char byte {1};
+        [[maybe_unused]] auto written {::write(fd, &byte, 1)};
+    }
+}
+
+struct EquityServer::Connection
+{
+    int fd {-1};
+    std::string input {};
+    std::string output {};
+
+    // Every request read and not yet written, in the order it arrived
+    std::deque<std::shared_ptr<Reply>> replies {};
+    std::size_t lines {0};
+
+    bool readClosed {false};
+    bool failed {false};
+};
+
+EquityServer::EquityServer(unsigned threads, std::uint64_t seed, const PreflopTable* preflop, EquityCache& cache)
+: m_threads {threads}, m_seed {seed}, m_preflop {preflop}, m_cache {cache}
+{
+    int fds[2] {-1, -1};
+    if (pipe2(fds, O_NONBLOCK | O_CLOEXEC) == 0)
+    {
+        m_wakeRead = fds[0];
+        m_wakeWrite = fds[1];
+    }
+
+    // Builds the evaluator tables now rather than during the first request
+    HandStrength::evaluate(*CardSet::fromString("2c3d4h5s7c"));
+}
+
+EquityServer::~EquityServer()
+{
+    for (const auto& connection : m_connections)
+    {
+        close(connection->fd);
+    }
+    if (m_listenFd >= 0)
+    {
+        close(m_listenFd);
+    }
+    if (!m_socketPath.empty())
+    {
+        unlink(m_socketPath.c_str());
+    }
+    close(m_wakeRead);
+    close(m_wakeWrite);
+}
+
+std::string EquityServer::listen(const std::string& address)
+{
+    if (m_wakeRead < 0)
+    {
+        return "could not create the wake pipe";
+    }
+
+    bool isPort {!address.empty() && address.size() <= 5 && address.find_first_not_of("0123456789") == std::string::npos};
+    int fd {-1};
+    int bound {-1};
+
+    if (isPort)
+    {
+        auto port {std::stoul(address)};
+        if (port > 65535)
+        {
+            return "bad port " + address;
+        }
+
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        int one {1};
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+        sockaddr_in local {};
+        local.sin_family = AF_INET;
+        local.sin_port = htons(static_cast<std::uint16_t>(port));
+        local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bound = (fd < 0) ? -1 : bind(fd, reinterpret_cast<const sockaddr*>(&local), sizeof(local));
+    }
+    else
+    {
+        sockaddr_un local {};
+        if (address.empty() || address.size() >= sizeof(local.sun_path))
+        {
+            return "bad socket path " + address;
+        }
+
+        local.sun_family = AF_UNIX;
+        std::copy(address.begin(), address.end(), local.sun_path);
+        unlink(address.c_str());
+
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        bound = (fd < 0) ? -1 : bind(fd, reinterpret_cast<const sockaddr*>(&local), sizeof(local));
+        if (bound == 0)
+        {
+            m_socketPath = address;
+        }
+    }
+
+    if (bound != 0 || ::listen(fd, SOMAXCONN) != 0)
+    {
+        std::string error {std::strerror(errno)};
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return "could not listen on " + address + ": " + error;
+    }
+
+    m_listenFd = fd;
+    return {};
+}
+
+void EquityServer::stop()
+{
+    m_stopping.store(true);
+    wakeUp(m_wakeWrite);
+}
+
+void EquityServer::accept()
+{
+    while (true)
+    {
+        int fd {accept4(m_listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)};
+        if (fd < 0)
+        {
+            return;
+        }
+
+        // Replies are small and each one is waited for, so they go out at once (this fails harmlessly on Unix sockets)
+        int one {1};
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        m_connections.push_back(std::make_unique<Connection>());
+        m_connections.back()->fd = fd;
+    }
+}
+
+void EquityServer::answer(Connection& connection, std::string_view line, ThreadPool& pool)
+{
+    auto lineNumber {++connection.lines};
+    auto first {line.find_first_not_of(" \t\r")};
+    if (first == std::string_view::npos || line[first] == '#')
+    {
+        return;
+    }
+
+    auto reply {std::make_shared<Reply>()};
+    connection.replies.push_back(reply);
+
+    BatchRequest request {};
+    auto error {parseScenario(line, request)};
+    if (!error.empty())
+    {
+        reply->text = "line=" + std::to_string(lineNumber) + " error=" + error + "\n";
+        reply->done.store(true);
+        return;
+    }
+
+    auto key {EquityCache::key(request.scenario)};
+    if (auto cached {m_cache.find(key, request.trials, request.precision)})
+    {
+        reply->text = formatResult(lineNumber, *cached, request.odds);
+        reply->done.store(true);
+        return;
+    }
+
+    if (m_preflop)
+    {
+        if (auto result {m_preflop->lookup(request.scenario)})
+        {
+            reply->text = formatResult(lineNumber, *result, request.odds);
+            reply->done.store(true);
+            return;
+        }
+    }
+
+    // Requests take streams in the order they arrive, across all connections
+    auto rng {Xoshiro256::stream(m_seed, m_requests++)};
+
+    pool.submit([this, reply, request = std::move(request), key = std::move(key), lineNumber, rng]() mutable
+    {
+        auto result {computeRequest(request, rng, m_preflop)};
+        if (!result.stopped)
+        {
+            m_cache.insert(key, result);
+        }
+        reply->text = formatResult(lineNumber, result, request.odds);
+        reply->done.store(true, std::memory_order_release);
+        wakeUp(m_wakeWrite);
+    });
+}
+
+void EquityServer::read(Connection& connection, ThreadPool& pool)
+{
+    // One read per wakeup keeps a busy client from holding up the others
+    char buffer[1 << 16];
+    auto got {recv(connection.fd, buffer, sizeof(buffer), 0)};
+    if (got > 0)
+    {
+        connection.input.append(buffer, static_cast<std::size_t>(got));
+    }
+    else if (got == 0)
+    {
+        connection.readClosed = true;
+    }
+    else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+    {
+        connection.failed = true;
+        return;
+    }
+
+    std::size_t start {0};
+    for (auto end {connection.input.find('\n')}; end != std::string::npos; end = connection.input.find('\n', start))
+    {
+        answer(connection, std::string_view {connection.input}.substr(start, end - start), pool);
+        start = end + 1;
+    }
+    connection.input.erase(0, start);
+
+    if (connection.input.size() > maxLine)
+    {
+        auto reply {std::make_shared<Reply>()};
+        reply->text = "line=" + std::to_string(connection.lines + 1) + " error=line too long\n";
+        reply->done.store(true);
+        connection.replies.push_back(reply);
+        connection.readClosed = true;
+        connection.input.clear();
+    }
+    else if (connection.readClosed && !connection.input.empty())
+    {
+        answer(connection, connection.input, pool);
+        connection.input.clear();
+    }
+}
+
+void EquityServer::write(Connection& connection)
+{
+    while (!connection.replies.empty() && connection.replies.front()->done.load(std::memory_order_acquire))
+    {
+        connection.output += connection.replies.front()->text;
+        connection.replies.pop_front();
+    }
+
+    if (connection.output.empty())
+    {
+        return;
+    }
+
+    auto sent {send(connection.fd, connection.output.data(), connection.output.size(), MSG_NOSIGNAL)};
+    if (sent > 0)
+    {
+        connection.output.erase(0, static_cast<std::size_t>(sent));
+    }
+    else if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+    {
+        connection.failed = true;
+    }
+}
+
+void EquityServer::run()
+{
+    ThreadPool pool {m_threads};
+    std::vector<pollfd> polls {};
+
+    while (!m_stopping.load())
+    {
+        polls.clear();
+        polls.push_back(pollfd {m_wakeRead, POLLIN, 0});
+        polls.push_back(pollfd {m_listenFd, POLLIN, 0});
+        for (const auto& connection : m_connections)
+        {
+            short events {0};
+            if (!connection->readClosed && connection->replies.size() < maxPending)
+            {
+                events |= POLLIN;
+            }
+            if (!connection->output.empty())
+            {
+                events |= POLLOUT;
+            }
+            polls.push_back(pollfd {connection->fd, events, 0});
+        }
+
+        if (poll(polls.data(), polls.size(), -1) < 0)
+        {
+            continue;
+        }
+
+        if (polls[0].revents & POLLIN)
+        {
+            char drain[256];
+            while (::read(m_wakeRead, drain, sizeof(drain)) > 0)
+            {
+            }
+        }
+
+        for (std::size_t i {0}; i < m_connections.size(); ++i)
+        {
+            auto& connection {*m_connections[i]};
+            auto events {polls[i + 2].revents};
+            if (events & POLLIN)
+            {
+                read(connection, pool);
+            }
+            else if (events & (POLLERR | POLLHUP))
+            {
+                connection.failed = true;
+            }
+        }
+
+        if (polls[1].revents & POLLIN)
+        {
+            accept();
+        }
+
+        for (auto& connection : m_connections)
+        {
+            if (!connection->failed)
+            {
+                write(*connection);
+            }
+        }
+
+        std::erase_if(m_connections, [](const std::unique_ptr<Connection>& connection)
+        {
+            bool finished {connection->failed ||
+                (connection->readClosed && connection->replies.empty() && connection->output.empty())};
+            if (finished)
+            {
+                close(connection->fd);
+            }
+            return finished;
+        });
+    }
+}
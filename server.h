@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "preflopTable.h"
+#include "equityCache.h"
+
+class ThreadPool;
+
+// A long-running equity service. Clients connect over a Unix domain socket or TCP on 127.0.0.1 and write scenarios
+// in the batch line format (see batch.h), one per line, and get one reply per scenario in the runBatch output
+// format, numbered by its line on that connection. Replies come back in the order the lines were sent, so a client
+// may pipeline, writing many lines before reading any replies.
+//
+// One thread owns every connection. Each time it wakes it reads every complete line that has arrived, answers the
+// scenarios that need no real work straight away (cached results and preflop table spots), and hands the rest to the
+// worker pool together, so a slow request never holds up the others.
+// Finished replies are written back with one write per connection. The cache, the preflop table and the evaluator
+// tables stay loaded for every request.
+class EquityServer
+{
+    public:
+        EquityServer(unsigned threads, std::uint64_t seed, const PreflopTable* preflop, EquityCache& cache);
+        ~EquityServer();
+
+        EquityServer(const EquityServer&) = delete;
+        EquityServer& operator=(const EquityServer&) = delete;
+
+        // Listens on address: a port number for TCP on 127.0.0.1, or otherwise the path of a Unix socket, replacing
+        // any socket already there. Returns an error message, or an empty string once listening.
+        std::string listen(const std::string& address);
+
+        // Serves connections until stop() is called. Requests already handed to the workers are finished first.
+        void run();
+
+        // Makes run() return. Safe to call from any thread and from a signal handler.
+        void stop();
+
+    private:
+        struct Connection;
+
+        unsigned m_threads {};
+        std::uint64_t m_seed {};
+        std::uint64_t m_requests {0};
+        const PreflopTable* m_preflop {};
+        EquityCache& m_cache;
+
+        int m_listenFd {-1};
+        std::string m_socketPath {};
+
+        // Workers and stop() write a byte here to wake run()
+        int m_wakeRead {-1};
+        int m_wakeWrite {-1};
+        std::atomic<bool> m_stopping {false};
+
+        std::vector<std::unique_ptr<Connection>> m_connections {};
+
+        void accept();
+        void read(Connection& connection, ThreadPool& pool);
+        void answer(Connection& connection, std::string_view line, ThreadPool& pool);
+        void write(Connection& connection);
+};
@@ -1,3 +1,4 @@
+#include <random>
 #include "deck.cpp"
 
 int value(const Card& card)
@@ -159,7 +160,8 @@ int playBlackjack(Deck& deck)
 int main()
 {
     Deck deck {};
-    deck.shuffle();
+    Xoshiro256 rng {std::random_device {}()};
+    deck.shuffle(rng);
 
     playBlackjack(deck);
 
@@ -0,0 +1,1429 @@
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "deck.h"
+#include "range.h"
+#include "rng.h"
+#include "pokerGame.h"
+#include "equityCalc.h"
+#include "handStrength.h"
+#include "preflopTable.h"
+#include "profile.h"
+#include "simulation.h"
+
+CardSet Scenario::usedCards() const
+{
+    CardSet used {communalCards};
+    for (std::size_t i {0}; i < static_cast<std::size_t>(numHands); ++i)
+    {
+        used |= players.data()[i].hand;
+    }
+    return used;
+}
+
+const char* EquityResult::methodName() const
+{
+    static constexpr std::array names {"sampled", "exact", "preflop-table"};
+    return names[method];
+}
+
+EquityResult& EquityResult::operator+=(const EquityResult& other)
+{
+    wins += other.wins;
+    draws += other.draws;
+    trials += other.trials;
+    equityTotal += other.equityTotal;
+    equitySquares += other.equitySquares;
+    units += other.units;
+    unitTotal += other.unitTotal;
+    unitSquares += other.unitSquares;
+    controlTotal += other.controlTotal;
+    controlSquares += other.controlSquares;
+    controlCross += other.controlCross;
+    stopped = stopped || other.stopped;
+    if (other.controlled)
+    {
+        controlled = true;
+        controlMean = other.controlMean;
+    }
+
+    seatShares.resize(std::max(seatShares.size(), other.seatShares.size()));
+    for (std::size_t seat {0}; seat < other.seatShares.size(); ++seat)
+    {
+        seatShares[seat] += other.seatShares[seat];
+    }
+    return *this;
+}
+
+void EquityResult::record(Settings::GameStates state, int numWinners)
+{
+    ++trials;
+    if (state == Settings::win)
+    {
+        ++wins;
+        equityTotal += 1.0;
+        equitySquares += 1.0;
+    }
+    else if (state == Settings::draw)
+    {
+        ++draws;
+        double share {1.0 / numWinners};
+        equityTotal += share;
+        equitySquares += share * share;
+    }
+}
+
+// The least-squares slope of the units' mean share on their mean control, or zero without a usable control
+static double controlSlope(const EquityResult& result)
+{
+    if (!result.controlled || result.units < 3)
+    {
+        return 0.0;
+    }
+
+    auto n {static_cast<double>(result.units)};
+    double spread {result.controlSquares - result.controlTotal * result.controlTotal / n};
+    double covariance {result.controlCross - result.controlTotal * result.unitTotal / n};
+    return (spread > 1e-12) ? covariance / spread : 0.0;
+}
+
+double EquityResult::equity() const
+{
+    if (trials == 0)
+    {
+        return 0.0;
+    }
+
+    double mean {equityTotal / static_cast<double>(trials)};
+    if (double slope {controlSlope(*this)}; slope != 0.0)
+    {
+        auto n {static_cast<double>(units)};
+        mean = unitTotal / n - slope * (controlTotal / n - controlMean);
+    }
+    return mean;
+}
+
+double EquityResult::seatEquity(int seat) const
+{
+    auto index {static_cast<std::size_t>(seat)};
+    return (trials > 0 && index < seatShares.size()) ? seatShares[index] / static_cast<double>(trials) : 0.0;
+}
+
+double EquityResult::margin(double z) const
+{
+    if (method != sampled || trials < 2)
+    {
+        return (method == sampled) ? 1.0 : 0.0;
+    }
+
+    if (units > 1)
+    {
+        // Units are the independent observations. With a control variate, what is left of their spread once the
+        // fitted control is taken out, with one more degree of freedom spent on the slope.
+        auto n {static_cast<double>(units)};
+        double spread {unitSquares - unitTotal * unitTotal / n};
+        double freedom {n - 1};
+        if (double slope {controlSlope(*this)}; slope != 0.0)
+        {
+            spread -= slope * (controlCross - controlTotal * unitTotal / n);
+            freedom = n - 2;
+        }
+        return z * std::sqrt(std::max(0.0, spread / freedom) / n);
+    }
+
+    auto n {static_cast<double>(trials)};
+    double mean {equityTotal / n};
+    double variance {std::max(0.0, (equitySquares / n - mean * mean) * n / (n - 1))};
+    return z * std::sqrt(variance / n);
+}
+
+const char* Sampling::name(Method method)
+{
+    static constexpr std::array names {"plain", "stratified", "antithetic", "quasi"};
+    return names[method];
+}
+
+std::optional<Sampling::Method> Sampling::parse(std::string_view name)
+{
+    for (int method {0}; method < max_methods; ++method)
+    {
+        if (name == Sampling::name(static_cast<Method>(method)))
+        {
+            return static_cast<Method>(method);
+        }
+    }
+    return std::nullopt;
+}
+
+bool RunControl::stopRequested() const
+{
+    return (cancel && cancel->load(std::memory_order_relaxed)) || (deadline && Clock::now() >= *deadline);
+}
+
+RunControl RunControl::within(Clock::duration budget)
+{
+    RunControl control {};
+    control.deadline = Clock::now() + budget;
+    return control;
+}
+
+namespace
+{
+    // Called by a watched simulation after every batch of trials with its result so far
+    using BatchHook = std::function<void(const EquityResult&)>;
+
+    // One trial's unknown cards: two for each random seat in seat order, then the missing board cards
+    using Deal = std::array<CardCode, 2 * Settings::maxPlayers + 5>;
+
+    // What every trial of one simulate() call shares, and the showdown of a single deal
+    class Trials
+    {
+        public:
+            Trials(const Scenario& scenario, const Sampling& sampling, EquityResult& result)
+            : m_scenario {scenario}, m_players {scenario.players}, m_usedCards {scenario.usedCards()},
+              m_result {result}
+            {
+                // The alias tables are built once here, with the fixed hands and board already removed
+                for (const auto& range : scenario.ranges)
+                {
+                    m_samplers.emplace_back(range, m_usedCards);
+                    m_ready = m_ready && !m_samplers.back().empty();
+                }
+                m_ready = m_ready && rangesDealable();
+
+                m_firstRandomSeat = scenario.numHands + static_cast<int>(m_samplers.size());
+                seatCards = 2 * (scenario.numPlayers - m_firstRandomSeat);
+                boardCards = 5 - scenario.numCommunal;
+                m_result.seatShares.assign(static_cast<std::size_t>(scenario.numPlayers), 0.0);
+                m_stagedControls.reserve(batchTrials);
+
+                if (sampling.controlTable && sampling.controlTable->isOpen() && scenario.numHands > 0 &&
+                    scenario.ranges.empty() && seatCards > 0)
+                {
+                    setControl(*sampling.controlTable);
+                }
+            }
+
+            int seatCards {};
+            int boardCards {};
+
+            bool ready() const { return m_ready; }
+            bool hasRanges() const { return !m_samplers.empty(); }
+            CardSet usedCards() const { return m_usedCards; }
+
+            // Gives up after maxRangeDraws collisions in a row. A draw that succeeds has the same distribution
+            // whichever attempt it came on, so the samplers skip a trial that gives up without any bias.
+            static constexpr int maxRangeDraws {10000};
+            std::optional<CardSet> dealRanges(Xoshiro256& rng);
+
+            // Deals are staged and then played in batches, so that every seat's hand in a batch is scored by one
+            // call to the batch evaluator. stage() takes a deal along with the range hands dealt for it.
+            static constexpr std::size_t batchTrials {64};
+            bool batchFull() const { return m_stagedControls.size() == batchTrials; }
+            void stage(const Deal& deal);
+
+            // Plays the staged deals in the order they were staged, recording each and calling
+            // onTrial(share, control) with the hero's share of the pot and, with a control variate, its control value
+            template <typename Func>
+            void playStaged(Func& onTrial);
+
+            // Adds a unit whose trials averaged share and control
+            void recordUnit(double share, double control);
+
+            // With a control, the samplers ask between batches or units whether to go on. A stop marks the result
+            // stopped; otherwise the hook, if any, is shown the result so far.
+            void watch(const RunControl* control, const BatchHook* hook);
+            bool keepGoing();
+
+            // Also records every trial in byCard (indexed by card code) under the first board card its deal adds
+            void tagNextCards(std::vector<EquityResult>* byCard);
+
+        private:
+            const Scenario& m_scenario;
+            std::vector<Player> m_players {};
+            std::vector<RangeSampler> m_samplers {};
+            CardSet m_usedCards {};
+            EquityResult& m_result;
+            int m_firstRandomSeat {};
+            bool m_ready {true};
+
+            // The control value of each pair of hole cards, indexed by both orders of their codes, when controlled
+            std::vector<double> m_control {};
+
+            HandStrength::Batch m_batch {};
+            std::vector<double> m_stagedControls {};
+            std::vector<EquityResult>* m_byCard {nullptr};
+            std::vector<CardCode> m_stagedNextCards {};
+
+            const RunControl* m_runControl {nullptr};
+            const BatchHook* m_hook {nullptr};
+
+            void setControl(const PreflopTable& table);
+            bool rangesDealable() const;
+    };
+
+    void Trials::setControl(const PreflopTable& table)
+    {
+        int heroClass {PreflopTable::handClass(m_scenario.players.front().hand)};
+        m_control.assign(52 * 52, 0.0);
+
+        double total {0};
+        int pairs {0};
+        for (CardCode low {0}; low < 52; ++low)
+        {
+            for (CardCode high {static_cast<CardCode>(low + 1)}; high < 52; ++high)
+            {
+                CardSet hand {CardSet::bit(low) | CardSet::bit(high)};
+                if (hand.intersects(m_usedCards))
+                {
+                    continue;
+                }
+
+                const auto& cell {table.cell(heroClass, PreflopTable::handClass(hand))};
+                double equity {(static_cast<double>(cell.wins) + 0.5 * static_cast<double>(cell.draws)) /
+                    static_cast<double>(std::max<std::uint64_t>(cell.trials, 1))};
+                m_control[low * 52u + high] = equity;
+                m_control[high * 52u + low] = equity;
+                total += equity;
+                ++pairs;
+            }
+        }
+
+        // Every random seat's hand is uniform over the live pairs, so the average over them is the expectation
+        m_result.controlled = true;
+        m_result.controlMean = total / pairs;
+    }
+
+    // Whether every range seat can hold one of its live combos with no card shared, searched depth first. A search
+    // that runs out of steps counts as dealable, leaving the draw limit to bound the cost.
+    bool Trials::rangesDealable() const
+    {
+        std::int64_t steps {1000000};
+        auto search = [&](auto& self, std::size_t seat, CardSet dealt) -> bool
+        {
+            if (seat == m_samplers.size() || --steps < 0)
+            {
+                return true;
+            }
+            for (auto combo : m_samplers[seat].combos())
+            {
+                if (!combo.intersects(dealt) && self(self, seat + 1, dealt | combo))
+                {
+                    return true;
+                }
+            }
+            return false;
+        };
+        return search(search, 0, CardSet {});
+    }
+
+    // Gives each range seat a hand from its sampler. If two range hands share a card, every range hand is drawn
+    // again, which keeps the joint draw proportional to the product of the weights.
+    std::optional<CardSet> Trials::dealRanges(Xoshiro256& rng)
+    {
+        for (int attempt {0}; attempt < maxRangeDraws; ++attempt)
+        {
+            CardSet dealt {};
+            bool collided {false};
+
+            for (std::size_t i {0}; i < m_samplers.size() && !collided; ++i)
+            {
+                auto hand {m_samplers[i].sample(rng)};
+                collided = hand.intersects(dealt);
+                dealt |= hand;
+                m_players.data()[m_scenario.numHands + static_cast<int>(i)].hand = hand;
+            }
+
+            if (!collided)
+            {
+                return dealt;
+            }
+        }
+        return std::nullopt;
+    }
+
+    void Trials::stage(const Deal& deal)
+    {
+        Profile::Scope timer {Profile::stage};
+        double control {0};
+        for (int k {0}; k < seatCards; k += 2)
+        {
+            auto low {deal[static_cast<std::size_t>(k)]};
+            auto high {deal[static_cast<std::size_t>(k + 1)]};
+            m_players.data()[m_firstRandomSeat + k / 2].hand = CardSet {CardSet::bit(low) | CardSet::bit(high)};
+            if (!m_control.empty())
+            {
+                control += m_control[low * 52u + high];
+            }
+        }
+        m_stagedControls.push_back(control / std::max(seatCards / 2, 1));
+        if (m_byCard)
+        {
+            m_stagedNextCards.push_back(deal[static_cast<std::size_t>(seatCards)]);
+        }
+
+        CardSet board {m_scenario.communalCards};
+        for (int k {seatCards}; k < seatCards + boardCards; ++k)
+        {
+            board.mask |= CardSet::bit(deal[static_cast<std::size_t>(k)]);
+        }
+
+        m_batch.setBoard(board);
+        for (const auto& player : m_players)
+        {
+            m_batch.add(player.hand);
+        }
+    }
+
+    template <typename Func>
+    void Trials::playStaged(Func& onTrial)
+    {
+        m_batch.evaluate();
+        Profile::Scope timer {Profile::showdown};
+
+        auto seats {m_players.size()};
+        for (std::size_t trial {0}; trial < m_stagedControls.size(); ++trial)
+        {
+            HandStrength::Strength best {0};
+            int numBest {0};
+            for (std::size_t seat {0}; seat < seats; ++seat)
+            {
+                auto strength {m_batch.strength(trial * seats + seat)};
+                if (strength > best)
+                {
+                    best = strength;
+                    numBest = 1;
+                }
+                else if (strength == best)
+                {
+                    ++numBest;
+                }
+            }
+
+            for (std::size_t seat {0}; seat < seats; ++seat)
+            {
+                if (m_batch.strength(trial * seats + seat) == best)
+                {
+                    m_result.seatShares[seat] += 1.0 / numBest;
+                }
+            }
+
+            // The hero sits in seat 0
+            auto state {(m_batch.strength(trial * seats) < best) ? Settings::loss :
+                (numBest == 1) ? Settings::win : Settings::draw};
+            m_result.record(state, numBest);
+            if (m_byCard)
+            {
+                (*m_byCard)[m_stagedNextCards[trial]].record(state, numBest);
+            }
+
+            onTrial((state == Settings::win) ? 1.0 : (state == Settings::draw) ? 1.0 / numBest : 0.0,
+                m_stagedControls[trial]);
+        }
+
+        m_batch.clear();
+        m_stagedControls.clear();
+        m_stagedNextCards.clear();
+    }
+
+    void Trials::recordUnit(double share, double control)
+    {
+        ++m_result.units;
+        m_result.unitTotal += share;
+        m_result.unitSquares += share * share;
+        if (m_result.controlled)
+        {
+            m_result.controlTotal += control;
+            m_result.controlSquares += control * control;
+            m_result.controlCross += control * share;
+        }
+    }
+
+    void Trials::watch(const RunControl* control, const BatchHook* hook)
+    {
+        m_runControl = control;
+        m_hook = hook;
+    }
+
+    void Trials::tagNextCards(std::vector<EquityResult>* byCard)
+    {
+        m_byCard = byCard;
+        if (m_byCard)
+        {
+            m_byCard->assign(52, EquityResult {});
+            m_stagedNextCards.reserve(batchTrials);
+        }
+    }
+
+    bool Trials::keepGoing()
+    {
+        if (!m_runControl)
+        {
+            return true;
+        }
+
+        if (m_runControl->stopRequested())
+        {
+            m_result.stopped = true;
+            return false;
+        }
+
+        if (m_hook)
+        {
+            (*m_hook)(m_result);
+        }
+        return true;
+    }
+
+    // The live cards with their rank order reversed: the lowest card maps to the highest and so on. It is a
+    // bijection of the live cards, so mirroring a uniform deal gives another uniform deal, and a high runout's
+    // mirror is a low one.
+    std::array<CardCode, 52> mirror(CardSet deadCards)
+    {
+        std::array<CardCode, 52> byRank {};
+        std::size_t live {0};
+        for (int value {0}; value < Card::max_ranks; ++value)
+        {
+            for (int suit {0}; suit < Card::max_suits; ++suit)
+            {
+                auto code {static_cast<CardCode>(suit * Card::max_ranks + value)};
+                if (!(deadCards.mask & CardSet::bit(code)))
+                {
+                    byRank[live++] = code;
+                }
+            }
+        }
+
+        std::array<CardCode, 52> result {};
+        for (std::size_t i {0}; i < live; ++i)
+        {
+            result[byRank[i]] = byRank[live - 1 - i];
+        }
+        return result;
+    }
+
+    // The steps of the Kronecker sequence for dimensions dimensions (Roberts' R-sequence): the powers of one over
+    // the root of x^(dimensions + 1) = x + 1
+    std::vector<double> kroneckerSteps(int dimensions)
+    {
+        double root {2.0};
+        for (int i {0}; i < 50; ++i)
+        {
+            root = std::pow(1.0 + root, 1.0 / (dimensions + 1));
+        }
+
+        std::vector<double> steps(static_cast<std::size_t>(dimensions));
+        double power {1.0};
+        for (auto& step : steps)
+        {
+            power /= root;
+            step = power - std::floor(power);
+        }
+        return steps;
+    }
+}
+
+static void simulatePlain(Trials& trials, std::int64_t tries, Xoshiro256& rng, bool units)
+{
+    Deck deck {};
+    deck.removeDeadCards(trials.usedCards());
+    Deal deal {};
+    auto record = [&](double share, double control)
+    {
+        if (units)
+        {
+            trials.recordUnit(share, control);
+        }
+    };
+
+    for (std::int64_t n {0}; n < tries; ++n)
+    {
+        {
+            Profile::Scope timer {Profile::deal};
+            auto rangeCards {trials.dealRanges(rng)};
+            if (!rangeCards)
+            {
+                continue;
+            }
+
+            deck.startDeal();
+            for (int k {0}; k < trials.seatCards + trials.boardCards; ++k)
+            {
+                deal[static_cast<std::size_t>(k)] = deck.dealCard(rng, *rangeCards).code();
+            }
+        }
+
+        trials.stage(deal);
+        if (trials.batchFull())
+        {
+            trials.playStaged(record);
+            if (n + 1 < tries && !trials.keepGoing())
+            {
+                return;
+            }
+        }
+    }
+    trials.playStaged(record);
+}
+
+constexpr std::int64_t quasiBlockSize {64};
+
+// The trials in one unit of the sampler simulateWatched() picks for scenario, which rounds tries up to whole units
+static std::int64_t unitTrials(const Scenario& scenario, const Sampling& sampling)
+{
+    switch (sampling.method)
+    {
+        case Sampling::stratified:
+            return (scenario.ranges.empty() && scenario.numCommunal < 5) ? 52 - scenario.usedCards().size() : 1;
+        case Sampling::antithetic:
+            return 2;
+        case Sampling::quasi_random:
+            return quasiBlockSize;
+        default:
+            return 1;
+    }
+}
+
+// Each unit deals every live card as the first missing board card once, so the next card is spread evenly
+static void simulateStratified(Trials& trials, std::int64_t tries, Xoshiro256& rng)
+{
+    Deck deck {};
+    deck.removeDeadCards(trials.usedCards());
+    Deal deal {};
+
+    std::vector<CardCode> liveCards {};
+    for (CardCode code {0}; code < 52; ++code)
+    {
+        if (!(trials.usedCards().mask & CardSet::bit(code)))
+        {
+            liveCards.push_back(code);
+        }
+    }
+
+    auto strata {static_cast<std::int64_t>(liveCards.size())};
+    auto units {(tries + strata - 1) / strata};
+    for (std::int64_t unit {0}; unit < units; ++unit)
+    {
+        double shares {0};
+        double controls {0};
+        auto add = [&](double share, double control)
+        {
+            shares += share;
+            controls += control;
+        };
+
+        for (auto stratum : liveCards)
+        {
+            {
+                Profile::Scope timer {Profile::deal};
+                CardSet skip {CardSet::bit(stratum)};
+                deck.startDeal();
+                for (int k {0}; k < trials.seatCards + trials.boardCards; ++k)
+                {
+                    deal[static_cast<std::size_t>(k)] = (k == trials.seatCards) ? stratum : deck.dealCard(rng, skip).code();
+                }
+            }
+
+            trials.stage(deal);
+            if (trials.batchFull())
+            {
+                trials.playStaged(add);
+            }
+        }
+        trials.playStaged(add);
+        trials.recordUnit(shares / static_cast<double>(strata), controls / static_cast<double>(strata));
+        if (unit + 1 < units && !trials.keepGoing())
+        {
+            return;
+        }
+    }
+}
+
+static void simulateAntithetic(Trials& trials, std::int64_t tries, Xoshiro256& rng)
+{
+    Deck deck {};
+    deck.removeDeadCards(trials.usedCards());
+    Deal deal {};
+    Deal mirrored {};
+    auto cards {mirror(trials.usedCards())};
+
+    // A batch holds whole pairs, each deal staged just before its mirror
+    double firstShare {};
+    double firstControl {};
+    bool second {false};
+    auto record = [&](double share, double control)
+    {
+        if (second)
+        {
+            trials.recordUnit((firstShare + share) / 2, (firstControl + control) / 2);
+        }
+        firstShare = share;
+        firstControl = control;
+        second = !second;
+    };
+
+    auto pairs {(tries + 1) / 2};
+    for (std::int64_t pair {0}; pair < pairs; ++pair)
+    {
+        {
+            Profile::Scope timer {Profile::deal};
+            auto rangeCards {trials.dealRanges(rng)};
+            if (!rangeCards)
+            {
+                continue;
+            }
+            if (trials.hasRanges())
+            {
+                cards = mirror(trials.usedCards() | *rangeCards);
+            }
+
+            deck.startDeal();
+            for (int k {0}; k < trials.seatCards + trials.boardCards; ++k)
+            {
+                deal[static_cast<std::size_t>(k)] = deck.dealCard(rng, *rangeCards).code();
+                mirrored[static_cast<std::size_t>(k)] = cards[deal[static_cast<std::size_t>(k)]];
+            }
+        }
+
+        trials.stage(deal);
+        trials.stage(mirrored);
+        if (trials.batchFull())
+        {
+            trials.playStaged(record);
+            if (pair + 1 < pairs && !trials.keepGoing())
+            {
+                return;
+            }
+        }
+    }
+    trials.playStaged(record);
+}
+
+// Each unit is a block of the sequence under its own random shift, which makes every point uniform and the blocks
+// independent. Each coordinate in turn picks one of the cards not yet taken, the board cards taking the leading
+// coordinates.
+static void simulateQuasiRandom(Trials& trials, std::int64_t tries, Xoshiro256& rng)
+{
+    int dimensions {trials.seatCards + trials.boardCards};
+    auto steps {kroneckerSteps(dimensions)};
+    std::vector<double> point(steps.size());
+
+    // Live cards in rank order, so that nearby coordinates pick cards of nearby rank
+    std::array<CardCode, 52> base {};
+    std::size_t numLive {0};
+    auto setLive = [&](CardSet deadCards)
+    {
+        numLive = 0;
+        for (int value {0}; value < Card::max_ranks; ++value)
+        {
+            for (int suit {0}; suit < Card::max_suits; ++suit)
+            {
+                auto code {static_cast<CardCode>(suit * Card::max_ranks + value)};
+                if (!(deadCards.mask & CardSet::bit(code)))
+                {
+                    base[numLive++] = code;
+                }
+            }
+        }
+    };
+    setLive(trials.usedCards());
+
+    Deal deal {};
+    auto blocks {(tries + quasiBlockSize - 1) / quasiBlockSize};
+    for (std::int64_t block {0}; block < blocks; ++block)
+    {
+        for (auto& coordinate : point)
+        {
+            coordinate = rng.uniform();
+        }
+
+        double shares {0};
+        double controls {0};
+        std::int64_t played {0};
+        auto add = [&](double share, double control)
+        {
+            shares += share;
+            controls += control;
+            ++played;
+        };
+
+        for (std::int64_t n {0}; n < quasiBlockSize; ++n)
+        {
+            {
+                Profile::Scope timer {Profile::deal};
+                for (std::size_t d {0}; d < point.size(); ++d)
+                {
+                    point[d] += steps[d];
+                    point[d] -= (point[d] >= 1.0) ? 1.0 : 0.0;
+                }
+
+                auto rangeCards {trials.dealRanges(rng)};
+                if (!rangeCards)
+                {
+                    continue;
+                }
+                if (trials.hasRanges())
+                {
+                    setLive(trials.usedCards() | *rangeCards);
+                }
+
+                auto live {base};
+                auto remaining {numLive};
+                for (int d {0}; d < dimensions; ++d)
+                {
+                    auto pick {std::min(remaining - 1,
+                        static_cast<std::size_t>(point[static_cast<std::size_t>(d)] * static_cast<double>(remaining)))};
+                    int slot {(d < trials.boardCards) ? trials.seatCards + d : d - trials.boardCards};
+                    deal[static_cast<std::size_t>(slot)] = live[pick];
+
+                    std::copy(live.begin() + static_cast<std::ptrdiff_t>(pick + 1),
+                        live.begin() + static_cast<std::ptrdiff_t>(remaining), live.begin() + static_cast<std::ptrdiff_t>(pick));
+                    --remaining;
+                }
+            }
+
+            trials.stage(deal);
+            if (trials.batchFull())
+            {
+                trials.playStaged(add);
+            }
+        }
+        trials.playStaged(add);
+        if (played > 0)
+        {
+            trials.recordUnit(shares / static_cast<double>(played), controls / static_cast<double>(played));
+        }
+        if (block + 1 < blocks && !trials.keepGoing())
+        {
+            return;
+        }
+    }
+}
+
+static EquityResult simulateWatched(const Scenario& scenario, std::int64_t tries, Xoshiro256& rng,
+    const Sampling& sampling, const RunControl* control, const BatchHook* hook,
+    std::vector<EquityResult>* byCard = nullptr)
+{
+    EquityResult result {};
+    Trials trials {scenario, sampling, result};
+    trials.tagNextCards(byCard);
+    if (!trials.ready())
+    {
+        return result;
+    }
+    trials.watch(control, hook);
+
+    auto method {sampling.method};
+    if (method == Sampling::stratified && (trials.hasRanges() || trials.boardCards == 0))
+    {
+        method = Sampling::plain;
+    }
+
+    switch (method)
+    {
+        case Sampling::stratified:
+            simulateStratified(trials, tries, rng);
+            break;
+        case Sampling::antithetic:
+            simulateAntithetic(trials, tries, rng);
+            break;
+        case Sampling::quasi_random:
+            simulateQuasiRandom(trials, tries, rng);
+            break;
+        default:
+            simulatePlain(trials, tries, rng, result.controlled);
+            break;
+    }
+
+    return result;
+}
+
+EquityResult simulate(const Scenario& scenario, std::int64_t tries, Xoshiro256& rng, const Sampling& sampling)
+{
+    return simulateWatched(scenario, tries, rng, sampling, nullptr, nullptr);
+}
+
+namespace
+{
+    // Passes a run's result so far to control.onProgress at most once per interval, on the calling thread, adding
+    // what earlier calls of the same run have finished
+    class Progress
+    {
+        public:
+            explicit Progress(const RunControl& control)
+            : m_control {control}, m_next {RunControl::Clock::now() + control.progressInterval}
+            {}
+
+            EquityResult before {};
+
+            void offer(const EquityResult& partial)
+            {
+                auto now {RunControl::Clock::now()};
+                if (now < m_next || before.trials + partial.trials == 0)
+                {
+                    return;
+                }
+                m_next = now + m_control.progressInterval;
+
+                auto total {before};
+                total += partial;
+                m_control.onProgress(total);
+            }
+
+        private:
+            const RunControl& m_control;
+            RunControl::Clock::time_point m_next {};
+    };
+
+    // Where a worker of a threaded run leaves its result so far for the calling thread to report
+    struct ProgressSlot
+    {
+        std::mutex mutex {};
+        EquityResult result {};
+    };
+}
+
+// When byCard is given, each trial is also recorded under the first board card its deal adds
+static EquityResult simulateControlled(const Scenario& scenario, std::int64_t tries, unsigned threads,
+    Xoshiro256& rng, const Sampling& sampling, const RunControl& control, Progress* progress,
+    std::vector<EquityResult>* byCard = nullptr)
+{
+    const RunControl* watched {(control.canStop() || progress) ? &control : nullptr};
+    if (threads <= 1)
+    {
+        BatchHook hook {};
+        if (progress)
+        {
+            hook = [progress](const EquityResult& partial) { progress->offer(partial); };
+        }
+        return simulateWatched(scenario, tries, rng, sampling, watched, progress ? &hook : nullptr, byCard);
+    }
+
+    std::vector<EquityResult> results(threads);
+    std::vector<std::vector<EquityResult>> cardResults(byCard ? threads : 0);
+    std::vector<std::thread> workers {};
+    workers.reserve(threads);
+
+    std::vector<ProgressSlot> slots(progress ? threads : 0);
+    std::mutex finishedMutex {};
+    std::condition_variable finishedChanged {};
+    unsigned finished {0};
+
+    // Workers copy their result into their slot a few times per interval, and the calling thread adds them up
+    auto publishEvery {control.progressInterval / 4};
+
+    // Workers take whole units, the first few one more than the rest, so the run plays as many units as one thread
+    auto unit {unitTrials(scenario, sampling)};
+    auto units {(tries + unit - 1) / unit};
+    for (unsigned t {0}; t < threads; ++t)
+    {
+        std::int64_t share {(units / threads + ((t < units % threads) ? 1 : 0)) * unit};
+
+        // Each worker splits its own stream off rng, in worker order, so the totals only depend on rng and threads
+        workers.emplace_back([&, t, share, workerRng = rng.split()]() mutable
+        {
+            BatchHook hook {};
+            if (progress)
+            {
+                hook = [&slot = slots[t], publishEvery, next = RunControl::Clock::now()](const EquityResult& partial)
+                    mutable
+                {
+                    auto now {RunControl::Clock::now()};
+                    if (now >= next)
+                    {
+                        next = now + publishEvery;
+                        std::lock_guard lock {slot.mutex};
+                        slot.result = partial;
+                    }
+                };
+            }
+            results[t] = simulateWatched(scenario, share, workerRng, sampling, watched, progress ? &hook : nullptr,
+                byCard ? &cardResults[t] : nullptr);
+
+            std::lock_guard lock {finishedMutex};
+            ++finished;
+            finishedChanged.notify_one();
+        });
+    }
+
+    if (progress)
+    {
+        std::unique_lock lock {finishedMutex};
+        while (!finishedChanged.wait_for(lock, publishEvery, [&] { return finished == threads; }))
+        {
+            lock.unlock();
+            EquityResult sofar {};
+            for (auto& slot : slots)
+            {
+                std::lock_guard slotLock {slot.mutex};
+                sofar += slot.result;
+            }
+            progress->offer(sofar);
+            lock.lock();
+        }
+    }
+
+    EquityResult total {};
+    for (unsigned t {0}; t < threads; ++t)
+    {
+        workers[t].join();
+        total += results[t];
+    }
+
+    if (byCard)
+    {
+        byCard->assign(52, EquityResult {});
+        for (std::size_t code {0}; code < 52; ++code)
+        {
+            for (const auto& share : cardResults)
+            {
+                (*byCard)[code] += share[code];
+            }
+        }
+    }
+
+    return total;
+}
+
+EquityResult simulate(const Scenario& scenario, std::int64_t tries, unsigned threads, Xoshiro256& rng,
+    const Sampling& sampling, const RunControl& control)
+{
+    std::optional<Progress> progress {};
+    if (control.onProgress)
+    {
+        progress.emplace(control);
+    }
+    return simulateControlled(scenario, tries, threads, rng, sampling, control, progress ? &*progress : nullptr);
+}
+
+EquityResult simulateByNextCard(const Scenario& scenario, std::int64_t tries, unsigned threads, Xoshiro256& rng,
+    std::vector<EquityResult>& byCard)
+{
+    assert(scenario.numCommunal >= 3 && scenario.numCommunal < 5 && "simulateByNextCard needs a flop or turn");
+    return simulateControlled(scenario, tries, threads, rng, Sampling {Sampling::stratified}, RunControl {}, nullptr,
+        &byCard);
+}
+
+static double choose(int n, int k)
+{
+    if (k < 0 || k > n)
+    {
+        return 0;
+    }
+
+    double result {1};
+    for (int i {1}; i <= k; ++i)
+    {
+        result = result * (n - k + i) / i;
+    }
+    return result;
+}
+
+double exactShowdowns(const Scenario& scenario)
+{
+    int liveCards {52 - scenario.usedCards().size()};
+    int boardCards {5 - scenario.numCommunal};
+
+    double showdowns {choose(liveCards, boardCards)};
+    int restCards {liveCards - boardCards};
+
+    // Opponents are interchangeable, so their hands only need enumerating in one order
+    int opponents {0};
+    for (int seat {scenario.numHands}; seat < scenario.numPlayers; ++seat)
+    {
+        showdowns *= choose(restCards, 2);
+        restCards -= 2;
+
+        if (seat > 0)
+        {
+            showdowns /= ++opponents;
+        }
+    }
+
+    return showdowns;
+}
+
+// Evaluates every runout whose first board card (by position in the live cards) is worker modulo workers.
+// When byCard is given, each showdown is also recorded under every card the runout added to the board.
+static EquityResult enumerateShare(const Scenario& scenario, unsigned worker, unsigned workers,
+    std::vector<EquityResult>* byCard = nullptr)
+{
+    Profile::Scope timer {Profile::enumerate};
+    EquityResult result {};
+    result.method = EquityResult::exact;
+    CardSet runout {};
+
+    CardSet usedCards {scenario.usedCards()};
+    std::vector<CardSet> liveCards {};
+    for (CardCode code {0}; code < 52; ++code)
+    {
+        if (!(usedCards.mask & CardSet::bit(code)))
+        {
+            liveCards.push_back(CardSet {CardSet::bit(code)});
+        }
+    }
+
+    std::vector<CardSet> pairs {};
+    for (std::size_t i {0}; i < liveCards.size(); ++i)
+    {
+        for (std::size_t j {i + 1}; j < liveCards.size(); ++j)
+        {
+            pairs.push_back(liveCards[i] | liveCards[j]);
+        }
+    }
+
+    int unknownSeats {scenario.numPlayers - scenario.numHands};
+    bool heroUnknown {scenario.numHands == 0};
+
+    std::vector<std::size_t> livePairs {};
+    std::vector<HandStrength::Strength> pairStrengths(pairs.size());
+    std::vector<HandStrength::Strength> knownStrengths(static_cast<std::size_t>(scenario.numHands));
+    HandStrength::Batch batch {};
+
+    // Tallies count the showdowns won by each group of seats for each number of winners, and are turned into shares
+    // once: the known seats holding the best known hand split what they win on a board evenly, and so do the unknown
+    // opponents, which are enumerated in one order only
+    result.seatShares.assign(static_cast<std::size_t>(scenario.numPlayers), 0.0);
+    using Splits = std::array<std::int64_t, Settings::maxPlayers + 1>;
+    Splits knownSplits {};
+    Splits heroSplits {};
+    Splits opponentSplits {};
+    HandStrength::Strength knownBest {0};
+    int numKnownBest {0};
+    auto splitShares = [&](const Splits& splits)
+    {
+        double shares {0};
+        for (int numBest {1}; numBest <= scenario.numPlayers; ++numBest)
+        {
+            shares += static_cast<double>(splits[static_cast<std::size_t>(numBest)]) / numBest;
+        }
+        return shares;
+    };
+
+    auto tally = [&](HandStrength::Strength heroStrength, HandStrength::Strength bestStrength, int numBest)
+    {
+        auto state {(heroStrength < bestStrength) ? Settings::loss : (numBest == 1) ? Settings::win : Settings::draw};
+        result.record(state, numBest);
+
+        auto winners {static_cast<std::size_t>(numBest)};
+        int opponentsBest {numBest};
+        if (numKnownBest > 0 && knownBest == bestStrength)
+        {
+            ++knownSplits[winners];
+            opponentsBest -= numKnownBest;
+        }
+        if (heroUnknown && heroStrength == bestStrength)
+        {
+            ++heroSplits[winners];
+            --opponentsBest;
+        }
+        opponentSplits[winners] += opponentsBest;
+
+        if (byCard)
+        {
+            runout.forEach([&](Card card) { (*byCard)[card.code()].record(state, numBest); });
+        }
+    };
+
+    // Deals live pairs to the remaining unknown seats, each opponent taking a later pair than the one before
+    auto assign = [&](auto& self, int seat, std::size_t start, CardSet dealt, HandStrength::Strength heroStrength,
+        HandStrength::Strength bestStrength, int numBest) -> void
+    {
+        if (seat == unknownSeats)
+        {
+            tally(heroStrength, bestStrength, numBest);
+            return;
+        }
+
+        bool isHero {heroUnknown && seat == 0};
+        for (std::size_t i {start}; i < livePairs.size(); ++i)
+        {
+            auto pairIndex {livePairs[i]};
+            if (pairs[pairIndex].intersects(dealt))
+            {
+                continue;
+            }
+
+            auto strength {pairStrengths[pairIndex]};
+            auto best {std::max(bestStrength, strength)};
+            int count {(strength == best) ? ((bestStrength == best) ? numBest + 1 : 1) : numBest};
+
+            self(self, seat + 1, isHero ? 0 : i + 1, dealt | pairs[pairIndex], isHero ? strength : heroStrength,
+                best, count);
+        }
+    };
+
+    auto dealOpponents = [&](CardSet board, HandStrength::Strength heroStrength, HandStrength::Strength bestStrength,
+        int numBest)
+    {
+        // Each live pair is evaluated once per board, all in one batch, and reused for every seat it is dealt to
+        livePairs.clear();
+        batch.clear();
+        batch.setBoard(board);
+        for (std::size_t i {0}; i < pairs.size(); ++i)
+        {
+            if (!pairs[i].intersects(board))
+            {
+                livePairs.push_back(i);
+                batch.add(pairs[i]);
+            }
+        }
+
+        batch.evaluate();
+        for (std::size_t i {0}; i < livePairs.size(); ++i)
+        {
+            pairStrengths[livePairs[i]] = batch.strength(i);
+        }
+
+        assign(assign, 0, 0, board, heroStrength, bestStrength, numBest);
+    };
+
+    auto showdown = [&](CardSet board)
+    {
+        HandStrength::Strength heroStrength {0};
+        HandStrength::Strength bestStrength {0};
+        int numBest {0};
+
+        runout = CardSet {board.mask & ~scenario.communalCards.mask};
+        HandStrength::Board summary {board};
+        for (int seat {0}; seat < scenario.numHands; ++seat)
+        {
+            auto strength {summary.evaluate(scenario.players.data()[seat].hand)};
+            knownStrengths[static_cast<std::size_t>(seat)] = strength;
+            if (seat == 0)
+            {
+                heroStrength = strength;
+            }
+
+            if (numBest == 0 || strength > bestStrength)
+            {
+                bestStrength = strength;
+                numBest = 1;
+            }
+            else if (strength == bestStrength)
+            {
+                ++numBest;
+            }
+        }
+
+        knownBest = bestStrength;
+        numKnownBest = numBest;
+        knownSplits = {};
+        if (unknownSeats == 0)
+        {
+            tally(heroStrength, bestStrength, numBest);
+        }
+        else
+        {
+            dealOpponents(board, heroStrength, bestStrength, numBest);
+        }
+
+        if (numKnownBest > 0)
+        {
+            double knownShares {splitShares(knownSplits)};
+            for (std::size_t seat {0}; seat < knownStrengths.size(); ++seat)
+            {
+                if (knownStrengths[seat] == knownBest)
+                {
+                    result.seatShares[seat] += knownShares;
+                }
+            }
+        }
+    };
+
+    auto deal = [&](auto& self, std::size_t start, int cardsLeft, CardSet board) -> void
+    {
+        if (cardsLeft == 0)
+        {
+            showdown(board);
+            return;
+        }
+
+        for (std::size_t i {start}; i < liveCards.size(); ++i)
+        {
+            self(self, i + 1, cardsLeft - 1, board | liveCards[i]);
+        }
+    };
+
+    int boardCards {5 - scenario.numCommunal};
+    if (boardCards == 0)
+    {
+        if (worker == 0)
+        {
+            showdown(scenario.communalCards);
+        }
+    }
+    else
+    {
+        for (std::size_t first {worker}; first < liveCards.size(); first += workers)
+        {
+            deal(deal, first + 1, boardCards - 1, scenario.communalCards | liveCards[first]);
+        }
+    }
+
+    if (heroUnknown)
+    {
+        result.seatShares[0] += splitShares(heroSplits);
+    }
+    int firstOpponent {std::max(scenario.numHands, 1)};
+    double opponentShares {splitShares(opponentSplits) / (scenario.numPlayers - firstOpponent)};
+    for (int seat {firstOpponent}; seat < scenario.numPlayers; ++seat)
+    {
+        result.seatShares[static_cast<std::size_t>(seat)] += opponentShares;
+    }
+    return result;
+}
+
+// Runs enumerateShare on threads workers, summing their results and, when byCard is given, their per-card results
+static EquityResult enumerateAll(const Scenario& scenario, unsigned threads, std::vector<EquityResult>* byCard)
+{
+    assert(scenario.ranges.empty() && "enumerate does not support ranges");
+
+    threads = std::max(threads, 1u);
+    std::vector<EquityResult> results(threads);
+    std::vector<std::vector<EquityResult>> cardResults(byCard ? threads : 0, std::vector<EquityResult>(52));
+    std::vector<std::thread> workers {};
+    workers.reserve(threads);
+
+    for (unsigned t {1}; t < threads; ++t)
+    {
+        workers.emplace_back([&scenario, &results, &cardResults, byCard, t, threads]()
+        {
+            results[t] = enumerateShare(scenario, t, threads, byCard ? &cardResults[t] : nullptr);
+        });
+    }
+    results[0] = enumerateShare(scenario, 0, threads, byCard ? &cardResults[0] : nullptr);
+
+    EquityResult total {results[0]};
+    for (unsigned t {1}; t < threads; ++t)
+    {
+        workers[t - 1].join();
+        total += results[t];
+    }
+
+    if (byCard)
+    {
+        byCard->assign(52, EquityResult {});
+        for (std::size_t code {0}; code < 52; ++code)
+        {
+            (*byCard)[code].method = EquityResult::exact;
+            for (const auto& share : cardResults)
+            {
+                (*byCard)[code] += share[code];
+            }
+        }
+    }
+
+    return total;
+}
+
+EquityResult enumerate(const Scenario& scenario, unsigned threads)
+{
+    return enumerateAll(scenario, threads, nullptr);
+}
+
+EquityResult enumerateByNextCard(const Scenario& scenario, unsigned threads, std::vector<EquityResult>& byCard)
+{
+    assert(scenario.numCommunal >= 3 && scenario.numCommunal < 5 && "enumerateByNextCard needs a flop or turn");
+    return enumerateAll(scenario, threads, &byCard);
+}
+
+// The most showdowns calculate() and calculateToPrecision() may enumerate under control
+static double enumerationLimit(const RunControl& control)
+{
+    return control.deadline ? maxDeadlineShowdowns : std::numeric_limits<double>::infinity();
+}
+
+EquityResult calculate(const Scenario& scenario, std::int64_t tries, unsigned threads, Xoshiro256& rng,
+    const PreflopTable* preflop, const Sampling& sampling, const RunControl& control)
+{
+    if (preflop)
+    {
+        if (auto result {preflop->lookup(scenario)})
+        {
+            return *result;
+        }
+    }
+
+    if (scenario.ranges.empty() &&
+        exactShowdowns(scenario) <= std::min(static_cast<double>(tries), enumerationLimit(control)))
+    {
+        return enumerate(scenario, threads);
+    }
+
+    return simulate(scenario, tries, threads, rng, sampling, control);
+}
+
+EquityResult calculate(const Scenario& scenario, std::int64_t tries, Xoshiro256& rng, const PreflopTable* preflop,
+    const Sampling& sampling)
+{
+    return calculate(scenario, tries, 1, rng, preflop, sampling);
+}
+
+EquityResult calculateToPrecision(const Scenario& scenario, double targetMargin, std::int64_t maxTries,
+    unsigned threads, Xoshiro256& rng, const PreflopTable* preflop, double z, const Sampling& sampling,
+    const RunControl& control)
+{
+    if (preflop)
+    {
+        if (auto result {preflop->lookup(scenario)})
+        {
+            return *result;
+        }
+    }
+
+    // A share of the pot lies in [0, 1], so its variance is at most 1/4
+    double worstCaseTries {0.25 * (z / targetMargin) * (z / targetMargin)};
+    if (scenario.ranges.empty() && exactShowdowns(scenario) <=
+        std::min({worstCaseTries, static_cast<double>(maxTries), enumerationLimit(control)}))
+    {
+        return enumerate(scenario, threads);
+    }
+
+    constexpr std::int64_t minBatch {1000};
+
+    std::optional<Progress> progress {};
+    if (control.onProgress)
+    {
+        progress.emplace(control);
+    }
+
+    EquityResult total {};
+    std::int64_t batch {minBatch};
+    while (total.trials < maxTries)
+    {
+        if (progress)
+        {
+            progress->before = total;
+        }
+        total += simulateControlled(scenario, std::min(batch, maxTries - total.trials), threads, rng, sampling, control,
+            progress ? &*progress : nullptr);
+        if (total.stopped || total.trials == 0 || total.margin(z) <= targetMargin)
+        {
+            break;
+        }
+
+        // Aim at the sample size the current variance estimate needs, at most doubling the trials so far
+        double scale {total.margin(z) / targetMargin};
+        auto needed {static_cast<std::int64_t>(static_cast<double>(total.trials) * (scale * scale - 1.0))};
+        batch = std::clamp(needed, minBatch, total.trials);
+    }
+
+    return total;
+}
+
+EquityResult calculateToPrecision(const Scenario& scenario, double targetMargin, std::int64_t maxTries,
+    Xoshiro256& rng, const PreflopTable* preflop, double z, const Sampling& sampling)
+{
+    return calculateToPrecision(scenario, targetMargin, maxTries, 1, rng, preflop, z, sampling);
+}
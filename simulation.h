@@ -0,0 +1,175 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string_view>
+#include <vector>
+#include "pokerGame.h"
+#include "deck.h"
+#include "range.h"
+#include "rng.h"
+
+class PreflopTable;
+
+// Everything known before the runouts are dealt. Seat 0 is the player whose equity is measured.
+// The first numHands seats hold fixed hands, the next ranges.size() seats are dealt from their ranges
+// and the rest get random hands.
+struct Scenario
+{
+    int numPlayers {};
+    int numHands {};
+    std::vector<Player> players {};
+    std::vector<Range> ranges {};
+    int numCommunal {};
+    CardSet communalCards {};
+
+    CardSet usedCards() const;
+};
+
+struct EquityResult
+{
+    std::int64_t wins {0};
+    std::int64_t draws {0};
+    std::int64_t trials {0};
+
+    // Sums over the trials of the hero's share of the pot (1 for a win, 1/n for an n-way split) and of its square
+    double equityTotal {0};
+    double equitySquares {0};
+
+    // Sums over the trials of every seat's share of the pot, in seat order. The preflop table leaves these empty.
+    std::vector<double> seatShares {};
+
+    enum Method
+    {
+        sampled,
+        exact,
+        preflop_table,
+
+        max_methods
+    };
+
+    Method method {sampled};
+
+    // True when a RunControl ended the sampling before every trial asked for had run
+    bool stopped {false};
+
+    // Samplers other than plain, and sampling with a control variate, also record units: independent groups of
+    // equally many trials, such as an antithetic pair, whose mean share is unbiased. margin() is then taken over the
+    // units' mean shares, whose squares unitSquares sums. With a control variate, the control sums hold each unit's
+    // mean control, its square and its product with the unit's mean share, and controlMean is its known expectation.
+    std::int64_t units {0};
+    double unitTotal {0};
+    double unitSquares {0};
+    bool controlled {false};
+    double controlMean {0};
+    double controlTotal {0};
+    double controlSquares {0};
+    double controlCross {0};
+
+    std::int64_t losses() const { return trials - wins - draws; }
+    const char* methodName() const;
+
+    void record(Settings::GameStates state, int numWinners);
+
+    // The mean share, corrected by the control variate when there is one. seatEquity() is always the plain mean.
+    double equity() const;
+    double seatEquity(int seat) const;
+
+    // Half-width of the confidence interval around equity() for a normal quantile z (1.96 for 95%).
+    // Zero for exact and table results.
+    double margin(double z = 1.96) const;
+
+    EquityResult& operator+=(const EquityResult& other);
+};
+
+// How simulate() draws its trials. Every method is unbiased; the ones other than plain aim at a smaller margin for
+// the same number of trials, at a small cost per trial.
+struct Sampling
+{
+    enum Method
+    {
+        plain,          // independent trials
+        stratified,     // units of one trial for each live card as the next board card; plain with ranges or a river
+        antithetic,     // pairs, the second trial mirroring the first's unknown cards through the live cards by rank
+        quasi_random,   // randomly shifted blocks of a Kronecker low-discrepancy sequence mapped onto the deal
+
+        max_methods
+    };
+
+    Method method {plain};
+
+    // With a table, the hero's preflop equity against each random opponent's hole cards, averaged over them, is used
+    // as a control variate. Needs a fixed hero hand, a random opponent and no ranges, and is ignored otherwise.
+    const PreflopTable* controlTable {nullptr};
+
+    static const char* name(Method method);
+    static std::optional<Method> parse(std::string_view name);
+};
+
+// Lets a caller watch a long calculation and end it early. Sampling checks between batches of trials whether it
+// should stop, and a stopped calculation returns the trials it had finished, marked stopped: still unbiased, only
+// less precise. A calculation that is never stopped gives exactly the result it would without a control.
+struct RunControl
+{
+    using Clock = std::chrono::steady_clock;
+
+    // Called on the calling thread with the result so far, about once per progressInterval while sampling
+    std::function<void(const EquityResult&)> onProgress {};
+    Clock::duration progressInterval {std::chrono::milliseconds {100}};
+
+    // Sampling stops once cancel is set, from any thread or a signal handler, or once the deadline has passed
+    const std::atomic<bool>* cancel {nullptr};
+    std::optional<Clock::time_point> deadline {};
+
+    bool canStop() const { return cancel || deadline; }
+    bool stopRequested() const;
+
+    // A control whose deadline is budget from now
+    static RunControl within(Clock::duration budget);
+};
+
+EquityResult simulate(const Scenario& scenario, std::int64_t tries, Xoshiro256& rng, const Sampling& sampling = {});
+
+// Splits tries across threads workers, each with its own Deck, counters and generator split off rng
+EquityResult simulate(const Scenario& scenario, std::int64_t tries, unsigned threads, Xoshiro256& rng,
+    const Sampling& sampling = {}, const RunControl& control = {});
+
+// How many showdowns enumerate() would evaluate: every remaining board, and every unordered assignment of hole
+// cards to the seats without a fixed hand
+double exactShowdowns(const Scenario& scenario);
+
+// Walks every remaining runout instead of sampling, so the result is exact. Scenarios with ranges are not supported.
+EquityResult enumerate(const Scenario& scenario, unsigned threads);
+
+// The same enumeration, also filling byCard (indexed by card code) with the hero's results over the runouts that
+// contain each card, which on a flop or turn is the equity once that card comes next. Each runout is evaluated once
+// however many cards it is credited to. Cards already known are left empty.
+EquityResult enumerateByNextCard(const Scenario& scenario, unsigned threads, std::vector<EquityResult>& byCard);
+
+// Its sampled counterpart: tries stratified trials, rounded up to whole units of one trial for each live next card
+// (plain trials with ranges), with byCard filled with the trials under each next card. The result holds every trial
+// in byCard, so it is their sum, with the stratified units for its margin. Needs a flop or turn.
+EquityResult simulateByNextCard(const Scenario& scenario, std::int64_t tries, unsigned threads, Xoshiro256& rng,
+    std::vector<EquityResult>& byCard);
+
+// Enumeration cannot stop part way without bias, so under a deadline calculate() and calculateToPrecision() only
+// enumerate spots of at most this many showdowns, a few milliseconds of work. Cancelling waits for an enumeration.
+constexpr double maxDeadlineShowdowns {100000};
+
+// Samples in checked batches until margin(z) is at most targetMargin, or maxTries trials have run.
+// Scenarios that could be enumerated in fewer showdowns than the worst case needs are answered exactly.
+EquityResult calculateToPrecision(const Scenario& scenario, double targetMargin, std::int64_t maxTries,
+    unsigned threads, Xoshiro256& rng, const PreflopTable* preflop = nullptr, double z = 1.96,
+    const Sampling& sampling = {}, const RunControl& control = {});
+EquityResult calculateToPrecision(const Scenario& scenario, double targetMargin, std::int64_t maxTries,
+    Xoshiro256& rng, const PreflopTable* preflop = nullptr, double z = 1.96, const Sampling& sampling = {});
+
+// Answers heads-up preflop spots from preflop when one is given, enumerates when that takes no more showdowns
+// than sampling tries runouts would and there are no ranges, and samples otherwise
+EquityResult calculate(const Scenario& scenario, std::int64_t tries, unsigned threads, Xoshiro256& rng,
+    const PreflopTable* preflop = nullptr, const Sampling& sampling = {}, const RunControl& control = {});
+EquityResult calculate(const Scenario& scenario, std::int64_t tries, Xoshiro256& rng,
+    const PreflopTable* preflop = nullptr, const Sampling& sampling = {});
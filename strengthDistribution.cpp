@@ -0,0 +1,299 @@
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "deck.h"
+#include "handStrength.h"
+#include "profile.h"
+#include "range.h"
+#include "rng.h"
+#include "strengthDistribution.h"
+
+namespace
+{
+    struct TwoCards
+    {
+        CardSet cards {};
+        CardCode low {};
+        CardCode high {};
+        double weight {1.0};
+    };
+
+    TwoCards twoCards(CardSet cards, double weight)
+    {
+        assert(cards.size() == 2);
+        return TwoCards {cards, static_cast<CardCode>(std::countr_zero(cards.mask)),
+            static_cast<CardCode>(63 - std::countl_zero(cards.mask)), weight};
+    }
+
+    // One worker's sums over its runouts, hand by hand
+    struct Sums
+    {
+        std::vector<double> histogram {};
+        std::vector<double> strength {};
+        std::vector<double> squares {};
+        std::vector<std::int64_t> runouts {};
+
+        Sums(std::size_t hands, int bins)
+        : histogram(hands * static_cast<std::size_t>(bins)), strength(hands), squares(hands), runouts(hands)
+        {}
+    };
+
+    constexpr std::uint64_t sortKey(HandStrength::Strength strength, std::size_t index)
+    {
+        return (std::uint64_t {strength} << 32) | index;
+    }
+
+    constexpr HandStrength::Strength keyStrength(std::uint64_t key)
+    {
+        return static_cast<HandStrength::Strength>(key >> 32);
+    }
+
+    constexpr std::size_t keyIndex(std::uint64_t key)
+    {
+        return static_cast<std::size_t>(key & 0xFFFFFFFF);
+    }
+}
+
+std::vector<CardSet> allHands(CardSet deadCards)
+{
+    std::vector<CardSet> hands {};
+    for (CardCode low {0}; low < 52; ++low)
+    {
+        for (CardCode high {static_cast<CardCode>(low + 1)}; high < 52; ++high)
+        {
+            CardSet hand {CardSet::bit(low) | CardSet::bit(high)};
+            if (!hand.intersects(deadCards))
+            {
+                hands.push_back(hand);
+            }
+        }
+    }
+    return hands;
+}
+
+// On one runout, with the opponent's combos sorted by strength, a hand's wins are the weight of the weaker combos less
+// those holding either of its cards, and likewise for ties and the total. Walking the hands in order of strength
+// keeps those running sums, per card, so no hand is compared with the combos one by one.
+static void scoreRunouts(const std::vector<TwoCards>& hands, const std::vector<TwoCards>& opponents,
+    const std::vector<double>& pairWeight, const std::vector<CardSet>& boards, std::size_t first, std::size_t end,
+    int bins, Sums& sums)
+{
+    std::vector<std::uint64_t> opponentOrder {};
+    std::vector<std::uint64_t> handOrder {};
+    opponentOrder.reserve(opponents.size());
+    handOrder.reserve(hands.size());
+
+    HandStrength::Batch batch {};
+
+    for (std::size_t b {first}; b < end; ++b)
+    {
+        CardSet runout {boards[b]};
+
+        // The live opponent combos and then the live hands are scored in one batch, the keys holding only their
+        // indices until it has run
+        double total {0};
+        std::array<double, 52> totalCard {};
+        batch.clear();
+        batch.setBoard(runout);
+        opponentOrder.clear();
+        for (std::size_t i {0}; i < opponents.size(); ++i)
+        {
+            const auto& opponent {opponents[i]};
+            if (!opponent.cards.intersects(runout))
+            {
+                opponentOrder.push_back(i);
+                batch.add(opponent.cards);
+                total += opponent.weight;
+                totalCard[opponent.low] += opponent.weight;
+                totalCard[opponent.high] += opponent.weight;
+            }
+        }
+
+        handOrder.clear();
+        for (std::size_t h {0}; h < hands.size(); ++h)
+        {
+            if (!hands[h].cards.intersects(runout))
+            {
+                handOrder.push_back(h);
+                batch.add(hands[h].cards);
+            }
+        }
+
+        batch.evaluate();
+        for (std::size_t i {0}; i < opponentOrder.size(); ++i)
+        {
+            opponentOrder[i] = sortKey(batch.strength(i), opponentOrder[i]);
+        }
+        for (std::size_t i {0}; i < handOrder.size(); ++i)
+        {
+            handOrder[i] = sortKey(batch.strength(opponentOrder.size() + i), handOrder[i]);
+        }
+
+        {
+            Profile::Scope timer {Profile::sort};
+            std::sort(opponentOrder.begin(), opponentOrder.end());
+            std::sort(handOrder.begin(), handOrder.end());
+        }
+
+        double below {0};
+        double equal {0};
+        std::array<double, 52> belowCard {};
+        std::array<double, 52> equalCard {};
+        std::size_t next {0};
+        std::size_t groupEnd {0};
+        bool haveGroup {false};
+        HandStrength::Strength level {};
+
+        for (auto key : handOrder)
+        {
+            auto strength {keyStrength(key)};
+            if (!haveGroup || strength != level)
+            {
+                for (std::size_t i {next}; i < groupEnd; ++i)
+                {
+                    const auto& opponent {opponents[keyIndex(opponentOrder[i])]};
+                    equalCard[opponent.low] = 0;
+                    equalCard[opponent.high] = 0;
+                }
+                equal = 0;
+
+                for (; next < opponentOrder.size() && keyStrength(opponentOrder[next]) < strength; ++next)
+                {
+                    const auto& opponent {opponents[keyIndex(opponentOrder[next])]};
+                    below += opponent.weight;
+                    belowCard[opponent.low] += opponent.weight;
+                    belowCard[opponent.high] += opponent.weight;
+                }
+
+                for (groupEnd = next; groupEnd < opponentOrder.size() && keyStrength(opponentOrder[groupEnd]) == strength;
+                    ++groupEnd)
+                {
+                    const auto& opponent {opponents[keyIndex(opponentOrder[groupEnd])]};
+                    equal += opponent.weight;
+                    equalCard[opponent.low] += opponent.weight;
+                    equalCard[opponent.high] += opponent.weight;
+                }
+
+                haveGroup = true;
+                level = strength;
+            }
+
+            // The opponent combo made of exactly the hand's cards is counted under both cards, and always ties
+            auto h {keyIndex(key)};
+            const auto& hand {hands[h]};
+            double same {pairWeight[hand.low * 52u + hand.high]};
+            double live {total - totalCard[hand.low] - totalCard[hand.high] + same};
+            if (live <= 1e-9)
+            {
+                continue;
+            }
+
+            double wins {below - belowCard[hand.low] - belowCard[hand.high]};
+            double ties {equal - equalCard[hand.low] - equalCard[hand.high] + same};
+            double share {std::clamp((wins + 0.5 * ties) / live, 0.0, 1.0)};
+
+            auto bin {std::min(bins - 1, static_cast<int>(share * bins))};
+            sums.histogram[h * static_cast<std::size_t>(bins) + static_cast<std::size_t>(bin)] += 1;
+            sums.strength[h] += share;
+            sums.squares[h] += share * share;
+            ++sums.runouts[h];
+        }
+    }
+}
+
+std::vector<StrengthDistribution> strengthDistributions(const std::vector<CardSet>& hands, CardSet board,
+    const Range* opponent, unsigned threads, Xoshiro256& rng, int bins, std::int64_t maxRunouts)
+{
+    assert(board.size() <= 5 && bins > 0 && maxRunouts > 0);
+
+    std::vector<TwoCards> handCards {};
+    for (auto hand : hands)
+    {
+        handCards.push_back(twoCards(hand, 1.0));
+    }
+
+    std::vector<TwoCards> opponents {};
+    std::vector<double> pairWeight(52 * 52);
+    auto addOpponent = [&](CardSet cards, double weight)
+    {
+        if (!cards.intersects(board) && weight > 0)
+        {
+            opponents.push_back(twoCards(cards, weight));
+            pairWeight[opponents.back().low * 52u + opponents.back().high] = weight;
+        }
+    };
+    if (opponent)
+    {
+        for (const auto& combo : opponent->combos())
+        {
+            addOpponent(combo.cards, combo.weight);
+        }
+    }
+    else
+    {
+        for (auto cards : allHands(board))
+        {
+            addOpponent(cards, 1.0);
+        }
+    }
+
+    bool exact {};
+    auto boards {boardRunouts(board, maxRunouts, rng, exact)};
+
+    threads = static_cast<unsigned>(std::clamp<std::size_t>(threads, 1, std::max<std::size_t>(boards.size(), 1)));
+    std::vector<Sums> sums(threads, Sums {hands.size(), bins});
+
+    // Each worker owns a contiguous block of runouts and its own sums, merged once all have finished
+    std::vector<std::thread> workers {};
+    for (unsigned t {1}; t < threads; ++t)
+    {
+        workers.emplace_back(scoreRunouts, std::cref(handCards), std::cref(opponents), std::cref(pairWeight),
+            std::cref(boards), boards.size() * t / threads, boards.size() * (t + 1) / threads, bins, std::ref(sums[t]));
+    }
+    scoreRunouts(handCards, opponents, pairWeight, boards, 0, boards.size() / threads, bins, sums[0]);
+
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+
+    std::vector<StrengthDistribution> result(hands.size());
+    for (std::size_t h {0}; h < hands.size(); ++h)
+    {
+        auto& distribution {result[h]};
+        distribution.histogram.assign(static_cast<std::size_t>(bins), 0.0);
+        for (const auto& part : sums)
+        {
+            for (std::size_t bin {0}; bin < distribution.histogram.size(); ++bin)
+            {
+                distribution.histogram[bin] += part.histogram[h * static_cast<std::size_t>(bins) + bin];
+            }
+            distribution.ehs += part.strength[h];
+            distribution.ehsSquared += part.squares[h];
+            distribution.runouts += part.runouts[h];
+        }
+
+        if (distribution.runouts > 0)
+        {
+            auto runouts {static_cast<double>(distribution.runouts)};
+            for (auto& fraction : distribution.histogram)
+            {
+                fraction /= runouts;
+            }
+            distribution.ehs /= runouts;
+            distribution.ehsSquared /= runouts;
+        }
+    }
+
+    return result;
+}
+
+StrengthDistribution strengthDistribution(CardSet hand, CardSet board, const Range* opponent, unsigned threads,
+    Xoshiro256& rng, int bins, std::int64_t maxRunouts)
+{
+    return strengthDistributions({hand}, board, opponent, threads, rng, bins, maxRunouts).front();
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "deck.h"
+#include "range.h"
+#include "rng.h"
+
+// How a hand's strength against one opponent is spread over the runouts still to come. On each completed board the
+// hand's strength is the weighted share of the opponent's live combos it beats, ties counting half. The histogram
+// holds the fraction of runouts whose strength falls in each of its equal-width bins over [0, 1], and ehs and
+// ehsSquared are the mean strength and mean squared strength (EHS and EHS^2) over those runouts.
+struct StrengthDistribution
+{
+    std::vector<double> histogram {};
+    double ehs {};
+    double ehsSquared {};
+    std::int64_t runouts {};
+};
+
+constexpr int defaultStrengthBins {20};
+constexpr std::int64_t defaultStrengthRunouts {20000};
+
+// The distribution of every hand in hands on board, against opponent or against a random hand when opponent is null.
+// Runouts are enumerated when there are at most maxRunouts of them and sampled from rng otherwise, and are shared by
+// all the hands and split across threads. Each runout scores the opponent's live combos once and sorts them, so a
+// hand's strength costs one evaluation and a few lookups however wide the opponent's range is. Hands that share a
+// card with the board get an empty distribution.
+std::vector<StrengthDistribution> strengthDistributions(const std::vector<CardSet>& hands, CardSet board,
+    const Range* opponent, unsigned threads, Xoshiro256& rng, int bins = defaultStrengthBins,
+    std::int64_t maxRunouts = defaultStrengthRunouts);
+
+StrengthDistribution strengthDistribution(CardSet hand, CardSet board, const Range* opponent, unsigned threads,
+    Xoshiro256& rng, int bins = defaultStrengthBins, std::int64_t maxRunouts = defaultStrengthRunouts);
+
+// Every two-card hand that misses the dead cards, lowest codes first
+std::vector<CardSet> allHands(CardSet deadCards = {});
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// A fixed set of worker threads taking jobs from one queue. The destructor finishes the queued jobs and joins.
+class ThreadPool
+{
+    private:
+        std::vector<std::thread> m_workers {};
+        std::queue<std::function<void()>> m_jobs {};
+        std::mutex m_mutex {};
+        std::condition_variable m_ready {};
+        bool m_stopping {false};
+
+        void work()
+        {
+            while (true)
+            {
+                std::function<void()> job {};
+                {
+                    std::unique_lock lock {m_mutex};
+                    m_ready.wait(lock, [this] { return m_stopping || !m_jobs.empty(); });
+                    if (m_jobs.empty())
+                    {
+                        return;
+                    }
+                    job = std::move(m_jobs.front());
+                    m_jobs.pop();
+                }
+                job();
+            }
+        }
+
+    public:
+        explicit ThreadPool(unsigned threads)
+        {
+            m_workers.reserve(threads);
+            for (unsigned i {0}; i < std::max(threads, 1u); ++i)
+            {
+                m_workers.emplace_back([this] { work(); });
+            }
+        }
+
+        ~ThreadPool()
+        {
+            {
+                std::lock_guard lock {m_mutex};
+                m_stopping = true;
+            }
+            m_ready.notify_all();
+            for (auto& worker : m_workers)
+            {
+                worker.join();
+            }
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        unsigned size() const { return static_cast<unsigned>(m_workers.size()); }
+
+        template <typename Func>
+        auto submit(Func func) -> std::future<std::invoke_result_t<Func>>
+        {
+            auto task {std::make_shared<std::packaged_task<std::invoke_result_t<Func>()>>(std::move(func))};
+            auto result {task->get_future()};
+            {
+                std::lock_guard lock {m_mutex};
+                m_jobs.emplace([task] { (*task)(); });
+            }
+            m_ready.notify_one();
+            return result;
+        }
+};